@@ -1,4 +1,5 @@
 const gvd_Addon = require("./gvd2.0/build/Release/addon.node");
+const fileIO = require("./fileIO.js");
 
 // function jsSum() {
 //   let a = 3.14, b = 2.78;
@@ -16,7 +17,23 @@ const gvd_Addon = require("./gvd2.0/build/Release/addon.node");
 console.time("c++");
 let jsonObj = gvd_Addon.ComputeGVD("./data/random_100/_files.txt", 0.5);
 // gvd_Addon.Increment(0.2);
-console.log(JSON.stringify(jsonObj));
+console.log(JSON.stringify(fileIO.readOutputArrays(jsonObj)));
 // console.log(jsonObj["name"]);
 // console.log("r:" + r);
 console.timeEnd("c++");
+
+// the same on the libuv thread pool, Node stays responsive meanwhile
+console.time("c++ async");
+gvd_Addon.ComputeGVDAsync("./data/random_100/_files.txt", 0.5).then(result => {
+  console.timeEnd("c++ async");
+  // a newer UpdateAsync cancels this one, it then resolves with cancelled set
+  return gvd_Addon.UpdateAsync(0.0, (events, y) => console.log("events " + events + " at y " + y));
+}).then(result => console.log(JSON.stringify(fileIO.readOutputArrays(result))));
+
+// datasets kept loaded side by side, each with its own sweep
+const mazeEngine = new gvd_Addon.GvdEngine();
+const randomEngine = new gvd_Addon.GvdEngine();
+mazeEngine.ComputeGVD("./data/maze/_files.txt", 0.5);
+randomEngine.ComputeGVD("./data/random_100/_files.txt", 0.5);
+console.log(JSON.stringify(fileIO.readOutputArrays(mazeEngine.Update(0.0))));
+console.log(JSON.stringify(fileIO.readOutputArrays(randomEngine.Results())));
@@ -86,3 +86,48 @@ module.exports.readOutputFiles = function (fileData) {
 
   return rslt;
 }
+
+// the typed array result of ComputeGVD/Update in the shapes of readOutputFiles
+module.exports.readOutputArrays = function (result) {
+  var toPoints = function (section, i) {
+    var points = [];
+    for (var k = section.offsets[i]; k < section.offsets[i + 1]; ++k) {
+      var v = k * section.stride;
+      points.push({x: section.points[v], y: section.points[v + 1]});
+    }
+    return points;
+  };
+  var toLines = function (sections) {
+    var lines = [];
+    sections.forEach(section => {
+      if (!section) return;
+      for (var i = 0; i + 1 < section.offsets.length; ++i) {
+        // empty items are not in the files either
+        if (section.offsets[i] !== section.offsets[i + 1])
+          lines.push({points: toPoints(section, i)});
+      }
+    });
+    return lines;
+  };
+
+  var rslt = {};
+  if (result["sites"]) {
+    var polygons = toLines([result["sites"]]);
+    polygons.forEach(poly => poly.points.push(poly.points[0]));
+    rslt.sites = JSON.stringify(polygons);
+  }
+  if (result["edges"])
+    rslt.edges = JSON.stringify(toLines([result["edges"], result["curvedEdges"]]));
+  if (result["beachline"])
+    rslt.beachline = JSON.stringify(toLines([result["beachline"], result["beachlineCurves"]]));
+  var c = result["closeEvents"];
+  if (c) {
+    var closeEvents = [];
+    for (var i = 0; i + 1 < c.offsets.length; ++i) {
+      var v = c.offsets[i] * c.stride;
+      closeEvents.push({x: c.points[v], y: c.points[v + 1], yval: c.points[v + 2]});
+    }
+    rslt.closeEvents = JSON.stringify(closeEvents);
+  }
+  return rslt;
+}
@@ -1,17 +1,51 @@
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
 #include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <uv.h>
 
-#include "dataset.hh"
-#include "fortune.hh"
-#include "utils.hh"
+#include "sweepEngine.hh"
 
 // build with:
 // node-gyp configure build
 
 namespace
 {
-  std::string g_dataset;
-  std::vector<Event> g_queue;
+  // an engine and the lock that keeps its requests in turn
+  struct Sweep
+  {
+    std::mutex mutex;
+    std::unique_ptr<SweepEngine> engine;
+    // control of the newest Update, only used on the V8 thread
+    std::shared_ptr<SweepControl> latest;
+    // results of the last finished advance, Results() takes them under
+    // their own lock so it never waits for a sweep in progress
+    std::mutex resultsMutex;
+    std::shared_ptr<std::vector<ResultArrays> const> results;
+  };
+
+  //------------------------------------------------------------
+  // EngineState
+  // What one engine keeps between calls. Requests share it, so one
+  // finishing after its GvdEngine was collected does no harm.
+  //------------------------------------------------------------
+  struct EngineState
+  {
+    // persistent sweep so Update() only processes the scrubbed interval
+    std::shared_ptr<Sweep> sweep;
+    // ComputeGVD calls so far and the one sweep comes from, an older
+    // async call finishing late leaves a newer sweep in place
+    uint64_t computeCount = 0;
+    uint64_t sweepCompute = 0;
+  };
+
+  // engine of the module level functions
+  std::shared_ptr<EngineState> g_engine = std::make_shared<EngineState>();
   // std::vector<std::string> getDatasets()
   // {
   //   return {"./data/maze/_files.txt",
@@ -40,101 +74,426 @@ namespace
   //   // {label:"Paris city dataset", isMap: true, filename:"Paris_0_256.map"}, // TODO FIX
   //   // {label:"Shanghai city dataset", isMap: true, filename:"Shanghai_2_256.map"},
   // }
-}
 
-void ComputeGVD(const v8::FunctionCallbackInfo<v8::Value>& args)
-{
-  v8::Isolate* isolate = args.GetIsolate();
-  std::string msg;
-  std::string err;
-  std::string pPath("./output_polygons.txt");
-  std::string ePath("./output_edges.txt");
-  std::string bPath("./output_beachline.txt");
-  std::string cPath("./output_close.txt");
-  try
+  // hands the storage of data to a JS ArrayBuffer that frees it when collected
+  template <typename T>
+  v8::Local<v8::ArrayBuffer> externalBuffer(v8::Isolate* isolate, std::vector<T>&& data)
   {
-    if (args.Length() < 2)
+    if (data.empty())
+      return v8::ArrayBuffer::New(isolate, 0);
+    auto* pOwner = new std::vector<T>(std::move(data));
+    v8::Local<v8::Object> buffer = node::Buffer::New(isolate, reinterpret_cast<char*>(pOwner->data()), pOwner->size() * sizeof(T),
+      [](char*, void* hint) { delete static_cast<std::vector<T>*>(hint); }, pOwner).ToLocalChecked();
+    return buffer.As<v8::Uint8Array>()->Buffer();
+  }
+
+  char const* sectionName(ResultSection_e type)
+  {
+    switch (type)
     {
-      std::cout << "Compute GVD arg count too low\n";
-      return;
+      case ResultSection_e::POLYGONS: return "sites";
+      case ResultSection_e::EDGES: return "edges";
+      case ResultSection_e::CURVED_EDGES: return "curvedEdges";
+      case ResultSection_e::BEACHLINE_EDGES: return "beachline";
+      case ResultSection_e::BEACHLINE_CURVED_EDGES: return "beachlineCurves";
+      case ResultSection_e::CLOSE_EVENTS: return "closeEvents";
     }
+    throw std::runtime_error("Unknown result section");
+  }
 
-    char set[255];
-    args[0]->ToString()->WriteUtf8(&set[0], args[0]->ToString()->Utf8Length());
-    g_dataset.assign(&set[0], args[0]->ToString()->Utf8Length());
+  // delivers SweepControl progress to a JS callback on the V8 thread,
+  // values not delivered yet are replaced by newer ones
+  struct Progress
+  {
+    uv_async_t async;
+    std::atomic<size_t> events{0};
+    std::atomic<double> y{0.0};
+    v8::Global<v8::Function> callback;
+  };
 
-    double sweepline = args[1]->ToNumber()->Value();
+  void reportProgress(uv_async_t* pAsync)
+  {
+    auto* pProgress = static_cast<Progress*>(pAsync->data);
+    v8::Isolate* isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+    v8::Local<v8::Value> argv[] = {v8::Number::New(isolate, static_cast<double>(pProgress->events.load())),
+                                   v8::Number::New(isolate, pProgress->y.load())};
+    node::MakeCallback(isolate, isolate->GetCurrentContext()->Global(),
+                       v8::Local<v8::Function>::New(isolate, pProgress->callback), 2, argv, {0, 0});
+  }
 
-    auto polygons = processInputFiles(g_dataset);
-    g_queue = createDataQueue(polygons);
-    auto tmp = g_queue;
+  //------------------------------------------------------------
+  // Request
+  // One ComputeGVD (dataset set) or Update (dataset empty) call.
+  // run() does the work on whichever thread it is given and
+  // takes the results, createResult() turns them into JS on the
+  // V8 thread.
+  //------------------------------------------------------------
+  struct Request
+  {
+    std::shared_ptr<EngineState> state;
+    std::shared_ptr<Sweep> sweep;
+    std::string dataset;
+    Scalar_e scalar;
+    double sweepline;
+    uint64_t compute; // EngineState::computeCount of a ComputeGVD, 0 for Update
+    std::shared_ptr<SweepControl> control;
+    bool cancelled = false;
+    std::vector<ResultArrays> results;
     std::string msg;
     std::string err;
-    auto gvdResults = fortune(tmp, sweepline, msg, err);
-    gvdResults.polygons = polygons;
 
-    writeResults(gvdResults, pPath, ePath, bPath, cPath);
+    // async calls only
+    uv_work_t work;
+    v8::Global<v8::Promise::Resolver> resolver;
+    Progress* pProgress = nullptr; // freed once its handle is closed
+  };
+
+  void run(Request& rRequest)
+  {
+    // bad arguments leave nothing to run
+    if (!rRequest.err.empty()) return;
+    try
+    {
+      std::lock_guard<std::mutex> lock(rRequest.sweep->mutex);
+      // a newer Update came in while this one waited
+      if (rRequest.control->cancelled)
+      {
+        rRequest.cancelled = true;
+        return;
+      }
+      if (!rRequest.dataset.empty())
+      {
+        rRequest.sweep->engine = createSweepEngine(rRequest.scalar);
+        rRequest.sweep->engine->load(rRequest.dataset);
+      }
+      else if (!rRequest.sweep->engine)
+      {
+        throw std::runtime_error("Update called before ComputeGVD");
+      }
+      rRequest.cancelled = !rRequest.sweep->engine->advance(rRequest.sweepline, rRequest.msg, rRequest.err,
+                                                            rRequest.control.get());
+      if (!rRequest.cancelled)
+      {
+        rRequest.results = rRequest.sweep->engine->resultArrays();
+        auto results = std::make_shared<std::vector<ResultArrays> const>(rRequest.results);
+        std::lock_guard<std::mutex> resultsLock(rRequest.sweep->resultsMutex);
+        rRequest.sweep->results = results;
+      }
+    }
+    catch(const std::exception& e)
+    {
+      std::cout << "Error " << e.what() << '\n';
+      rRequest.err += "Error: " + std::string(e.what());
+    }
   }
-  catch(const std::exception& e)
+
+  //------------------------------------------------------------
+  // createResult
+  // The results of the request, one entry per section as
+  // {offsets: Uint32Array, points: Float64Array, stride}. Item i
+  // has the points offsets[i] up to offsets[i + 1], each stride
+  // values long. The arrays view the engine's output directly.
+  // A request given way to a newer Update has cancelled set and
+  // no sections.
+  //------------------------------------------------------------
+  v8::Local<v8::Object> createResult(v8::Isolate* isolate, Request& rRequest)
   {
-    std::cout << "Error " << e.what() << '\n';
-    err += "Error: " + std::string(e.what());
+    v8::Local<v8::Object> result = v8::Object::New(isolate);
+    for (auto&& s : rRequest.results)
+    {
+      auto offsetCount = s.offsets.size();
+      auto valueCount = s.values.size();
+      v8::Local<v8::Object> section = v8::Object::New(isolate);
+      section->Set(v8::String::NewFromUtf8(isolate, "offsets"),
+                   v8::Uint32Array::New(externalBuffer(isolate, std::move(s.offsets)), 0, offsetCount));
+      section->Set(v8::String::NewFromUtf8(isolate, "points"),
+                   v8::Float64Array::New(externalBuffer(isolate, std::move(s.values)), 0, valueCount));
+      section->Set(v8::String::NewFromUtf8(isolate, "stride"), v8::Integer::NewFromUnsigned(isolate, s.stride));
+      result->Set(v8::String::NewFromUtf8(isolate, sectionName(s.type)), section);
+    }
+    result->Set(v8::String::NewFromUtf8(isolate, "cancelled"), v8::Boolean::New(isolate, rRequest.cancelled));
+    result->Set(v8::String::NewFromUtf8(isolate, "msg"), v8::String::NewFromUtf8(isolate, rRequest.msg.c_str()));
+    result->Set(v8::String::NewFromUtf8(isolate, "err"), v8::String::NewFromUtf8(isolate, rRequest.err.c_str()));
+    return result;
   }
 
-  v8::Handle<v8::Object> result = v8::Object::New(isolate);
-  result->Set(v8::String::NewFromUtf8(isolate, "sites"), v8::String::NewFromUtf8(isolate, pPath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "edges"), v8::String::NewFromUtf8(isolate, ePath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "beachline"), v8::String::NewFromUtf8(isolate, bPath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "closeEvents"), v8::String::NewFromUtf8(isolate, cPath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "msg"), v8::String::NewFromUtf8(isolate, msg.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "err"), v8::String::NewFromUtf8(isolate, err.c_str()));
-  args.GetReturnValue().Set(result);
-}
+  // ComputeGVD(dataset, sweepline, scalar) arguments, false if too few
+  bool computeRequest(const v8::FunctionCallbackInfo<v8::Value>& args, std::shared_ptr<EngineState> const& state,
+                      Request& rRequest)
+  {
+    v8::Isolate* isolate = args.GetIsolate();
+    if (args.Length() < 2)
+    {
+      std::cout << "Compute GVD arg count too low\n";
+      return false;
+    }
 
-void Update(const v8::FunctionCallbackInfo<v8::Value>& args)
-{
-  v8::Isolate* isolate = args.GetIsolate();
-  std::string msg;
-  std::string err;
-  std::string pPath("./output_polygons.txt");
-  std::string ePath("./output_edges.txt");
-  std::string bPath("./output_beachline.txt");
-  std::string cPath("./output_close.txt");
-  try
+    rRequest.state = state;
+    rRequest.dataset = *v8::String::Utf8Value(isolate, args[0]);
+    rRequest.sweepline = args[1]->NumberValue(isolate->GetCurrentContext()).FromJust();
+
+    // optional scalar type - "double", "long-double" or "float128"
+    rRequest.scalar = Scalar_e::LONG_DOUBLE;
+    if (args.Length() > 2 && args[2]->IsString())
+      rRequest.scalar = scalarFromString(*v8::String::Utf8Value(isolate, args[2]));
+
+    rRequest.sweep = std::make_shared<Sweep>();
+    rRequest.compute = ++state->computeCount;
+    rRequest.control = std::make_shared<SweepControl>();
+    return true;
+  }
+
+  // Update(sweepline) arguments on the current sweep, false if too few
+  bool updateRequest(const v8::FunctionCallbackInfo<v8::Value>& args, std::shared_ptr<EngineState> const& state,
+                     Request& rRequest)
   {
+    v8::Isolate* isolate = args.GetIsolate();
     if (args.Length() < 1)
     {
       std::cout << "Compute GVD arg count too low\n";
-      return;
+      return false;
     }
 
-    double sweepline = args[0]->ToNumber()->Value();
-    auto tmp = g_queue;
-    auto gvdResults = fortune(tmp, sweepline, msg, err);
-    // gvdResults.polygons = polygons;
+    rRequest.state = state;
+    rRequest.sweep = state->sweep ? state->sweep : std::make_shared<Sweep>();
+    rRequest.sweepline = args[0]->NumberValue(isolate->GetCurrentContext()).FromJust();
+    rRequest.compute = 0;
+
+    // latest wins, an older Update still waiting or sweeping gives way
+    rRequest.control = std::make_shared<SweepControl>();
+    if (rRequest.sweep->latest)
+      rRequest.sweep->latest->cancelled = true;
+    rRequest.sweep->latest = rRequest.control;
+    return true;
+  }
+
+  // a ComputeGVD that loaded its dataset becomes the sweep Update
+  // continues, a failed one leaves the previous sweep in place
+  void install(Request const& request)
+  {
+    auto& state = *request.state;
+    if (request.compute < state.sweepCompute) return;
+    state.sweep = request.sweep;
+    state.sweepCompute = request.compute;
+  }
+
+  // back on the V8 thread once the pool has run the request
+  void resolve(uv_work_t* pWork, int)
+  {
+    std::unique_ptr<Request> request(static_cast<Request*>(pWork->data));
+    v8::Isolate* isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+    // runs the promise reactions before returning to the loop
+    node::CallbackScope callbackScope(isolate, v8::Object::New(isolate), {0, 0});
 
-    writeResults(gvdResults, pPath, ePath, bPath, cPath);
+    if (request->pProgress)
+      uv_close(reinterpret_cast<uv_handle_t*>(&request->pProgress->async),
+               [](uv_handle_t* pHandle) { delete static_cast<Progress*>(pHandle->data); });
+    if (request->compute && request->err.empty()) install(*request);
+    auto resolver = v8::Local<v8::Promise::Resolver>::New(isolate, request->resolver);
+    resolver->Resolve(isolate->GetCurrentContext(), createResult(isolate, *request)).FromJust();
   }
-  catch(const std::exception& e)
+
+  //------------------------------------------------------------
+  // queue
+  // Runs the request on the libuv thread pool and returns a
+  // promise of its result. Requests on different sweeps run at
+  // the same time, the ones on one sweep take turns. Failures
+  // resolve with err set, as the synchronous calls return them.
+  // A function as the last argument is called with the events
+  // processed and the current y while the sweep runs.
+  //------------------------------------------------------------
+  void queue(const v8::FunctionCallbackInfo<v8::Value>& args, std::unique_ptr<Request> request)
   {
-    std::cout << "Error " << e.what() << '\n';
+    v8::Isolate* isolate = args.GetIsolate();
+    auto resolver = v8::Promise::Resolver::New(isolate->GetCurrentContext()).ToLocalChecked();
+    args.GetReturnValue().Set(resolver->GetPromise());
+
+    if (!request->control)
+      request->control = std::make_shared<SweepControl>();
+    if (args.Length() > 0 && args[args.Length() - 1]->IsFunction())
+    {
+      auto* pProgress = new Progress();
+      uv_async_init(node::GetCurrentEventLoop(isolate), &pProgress->async, reportProgress);
+      pProgress->async.data = pProgress;
+      pProgress->callback.Reset(isolate, args[args.Length() - 1].As<v8::Function>());
+      request->pProgress = pProgress;
+      request->control->progress = [pProgress](size_t events, double y) {
+        pProgress->events = events;
+        pProgress->y = y;
+        uv_async_send(&pProgress->async);
+      };
+    }
 
-    err += "Error: " + std::string(e.what());
+    request->resolver.Reset(isolate, resolver);
+    request->work.data = request.get();
+    uv_queue_work(node::GetCurrentEventLoop(isolate), &request->work,
+                  [](uv_work_t* pWork) { run(*static_cast<Request*>(pWork->data)); }, resolve);
+    request.release();
   }
-  v8::Handle<v8::Object> result = v8::Object::New(isolate);
-  result->Set(v8::String::NewFromUtf8(isolate, "sites"), v8::String::NewFromUtf8(isolate, pPath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "edges"), v8::String::NewFromUtf8(isolate, ePath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "beachline"), v8::String::NewFromUtf8(isolate, bPath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "closeEvents"), v8::String::NewFromUtf8(isolate, cPath.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "msg"), v8::String::NewFromUtf8(isolate, msg.c_str()));
-  result->Set(v8::String::NewFromUtf8(isolate, "err"), v8::String::NewFromUtf8(isolate, err.c_str()));
-  args.GetReturnValue().Set(result);
+
+  void compute(const v8::FunctionCallbackInfo<v8::Value>& args, std::shared_ptr<EngineState> const& state)
+  {
+    Request request;
+    try
+    {
+      if (!computeRequest(args, state, request)) return;
+    }
+    catch(const std::exception& e)
+    {
+      std::cout << "Error " << e.what() << '\n';
+      request.err += "Error: " + std::string(e.what());
+    }
+    if (request.sweep)
+    {
+      run(request);
+      if (request.err.empty()) install(request);
+    }
+    args.GetReturnValue().Set(createResult(args.GetIsolate(), request));
+  }
+
+  void update(const v8::FunctionCallbackInfo<v8::Value>& args, std::shared_ptr<EngineState> const& state)
+  {
+    Request request;
+    if (!updateRequest(args, state, request)) return;
+    run(request);
+    args.GetReturnValue().Set(createResult(args.GetIsolate(), request));
+  }
+
+  // the sweep is current once the promise resolves
+  void computeAsync(const v8::FunctionCallbackInfo<v8::Value>& args, std::shared_ptr<EngineState> const& state)
+  {
+    std::unique_ptr<Request> request(new Request());
+    try
+    {
+      if (!computeRequest(args, state, *request)) return;
+    }
+    catch(const std::exception& e)
+    {
+      std::cout << "Error " << e.what() << '\n';
+      request->err += "Error: " + std::string(e.what());
+    }
+    queue(args, std::move(request));
+  }
+
+  // continues the sweep current at the call
+  void updateAsync(const v8::FunctionCallbackInfo<v8::Value>& args, std::shared_ptr<EngineState> const& state)
+  {
+    std::unique_ptr<Request> request(new Request());
+    if (!updateRequest(args, state, *request)) return;
+    queue(args, std::move(request));
+  }
+
+  // the results of the last finished advance without sweeping
+  void results(const v8::FunctionCallbackInfo<v8::Value>& args, std::shared_ptr<EngineState> const& state)
+  {
+    Request request;
+    if (state->sweep)
+    {
+      std::shared_ptr<std::vector<ResultArrays> const> results;
+      {
+        std::lock_guard<std::mutex> lock(state->sweep->resultsMutex);
+        results = state->sweep->results;
+      }
+      // the arrays are handed to JS, so the request keeps a copy
+      if (results) request.results = *results;
+    }
+    args.GetReturnValue().Set(createResult(args.GetIsolate(), request));
+  }
+}
+
+//------------------------------------------------------------
+// GvdEngine
+// A dataset kept loaded in JS: new GvdEngine() then the calls of
+// the module, ComputeGVD, Update, their Async forms and Results.
+// Each engine owns its polygons, event queue, sweep and results,
+// so several datasets stay ready side by side and switching
+// between them needs no new ingest.
+//------------------------------------------------------------
+class GvdEngine : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports)
+  {
+    v8::Isolate* isolate = exports->GetIsolate();
+    v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+    tpl->SetClassName(v8::String::NewFromUtf8(isolate, "GvdEngine"));
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    NODE_SET_PROTOTYPE_METHOD(tpl, "ComputeGVD", method<compute>);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "Update", method<update>);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "ComputeGVDAsync", method<computeAsync>);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "UpdateAsync", method<updateAsync>);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "Results", method<results>);
+
+    exports->Set(v8::String::NewFromUtf8(isolate, "GvdEngine"),
+                 tpl->GetFunction(isolate->GetCurrentContext()).ToLocalChecked());
+  }
+
+private:
+  typedef void (*handler_t)(const v8::FunctionCallbackInfo<v8::Value>&, std::shared_ptr<EngineState> const&);
+
+  GvdEngine() : m_state(std::make_shared<EngineState>()) {}
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args)
+  {
+    v8::Isolate* isolate = args.GetIsolate();
+    if (!args.IsConstructCall())
+    {
+      isolate->ThrowException(v8::Exception::TypeError(
+        v8::String::NewFromUtf8(isolate, "GvdEngine must be called with new")));
+      return;
+    }
+    auto* pEngine = new GvdEngine();
+    pEngine->Wrap(args.This());
+    args.GetReturnValue().Set(args.This());
+  }
+
+  template <handler_t H>
+  static void method(const v8::FunctionCallbackInfo<v8::Value>& args)
+  {
+    H(args, node::ObjectWrap::Unwrap<GvdEngine>(args.Holder())->m_state);
+  }
+
+  std::shared_ptr<EngineState> m_state;
+};
+
+void ComputeGVD(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+  compute(args, g_engine);
+}
+
+void Update(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+  update(args, g_engine);
+}
+
+// promise returning ComputeGVD, the sweep is current once it resolves
+void ComputeGVDAsync(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+  computeAsync(args, g_engine);
+}
+
+// promise returning Update of the sweep current at the call
+void UpdateAsync(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+  updateAsync(args, g_engine);
+}
+
+void Results(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+  results(args, g_engine);
 }
 
 void Initalize(v8::Local<v8::Object> exports)
 {
   NODE_SET_METHOD(exports, "ComputeGVD", ComputeGVD);
   NODE_SET_METHOD(exports, "Update", Update);
+  NODE_SET_METHOD(exports, "ComputeGVDAsync", ComputeGVDAsync);
+  NODE_SET_METHOD(exports, "UpdateAsync", UpdateAsync);
+  NODE_SET_METHOD(exports, "Results", Results);
+  GvdEngine::Init(exports);
 }
 
-NODE_MODULE(addon, Initalize)
\ No newline at end of file
+NODE_MODULE(addon, Initalize)
@@ -1,19 +1,53 @@
 {
+  "variables": {
+    # the engine is built once per scalar type, see scalar.hh
+    "engine_sources": [
+      "fortune.cc",
+      "dataset.cc",
+      "crossings.cc",
+      "utils.cc",
+      "nodeInsert.cc",
+      "math.cc",
+      "predicates.cc",
+      "types.cc",
+      "closeEventQueue.cc",
+      "sweepEngine.cc"
+    ]
+  },
+  "target_defaults": {
+    "cflags": ["-Wall", "-std=c++17", "-fPIC" ], # TODO optimization flags
+    "cflags!": [ '-fno-exceptions' ],
+    "cflags_cc!": [ '-fno-exceptions' ],
+  },
   "targets": [
+    {
+      "target_name": "gvd_double",
+      "type": "static_library",
+      "defines": [ "GVD_SCALAR=1" ],
+      "sources": [ "<@(engine_sources)" ]
+    },
+    {
+      "target_name": "gvd_long_double",
+      "type": "static_library",
+      "defines": [ "GVD_SCALAR=2" ],
+      "sources": [ "<@(engine_sources)" ]
+    },
+    {
+      "target_name": "gvd_float128",
+      "type": "static_library",
+      "defines": [ "GVD_SCALAR=3" ],
+      "sources": [ "<@(engine_sources)" ]
+    },
     {
       "target_name": "addon",
-      "sources": [ 
-        "addon.cc", 
-        "fortune.cc",
-        "dataset.cc",
-        "utils.cc",
-        "nodeInsert.cc",
-        "math.cc",
-        "types.cc"
-        ], 
-      "cflags": ["-Wall", "-std=c++14" ], # TODO optimization flags
-      "cflags!": [ '-fno-exceptions' ],
-      "cflags_cc!": [ '-fno-exceptions' ],
+      "sources": [
+        "addon.cc",
+        "sweepEngineSelect.cc",
+        "parallel.cc",
+        "marchingSquares.cc"
+        ],
+      "dependencies": [ "gvd_double", "gvd_long_double", "gvd_float128" ],
+      "libraries": [ "-lquadmath", "-pthread" ],
       # "include_dirs" : ["<!(node -e \"require('nan')\")", "<!(node -e \"require('streaming-worker-sdk')\")"]
     }
   ]
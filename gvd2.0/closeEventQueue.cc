@@ -0,0 +1,159 @@
+#include "closeEventQueue.hh"
+
+#include <stdexcept>
+
+namespace GVD_SCALAR_NS
+{
+
+CloseEventQueue::CloseEventQueue(CancelMode_e mode)
+  : m_entries(), m_heap(), m_freeSlots(), m_arcSlots(), m_seq(0), m_mode(mode)
+{}
+
+void CloseEventQueue::push(CloseEvent const& e)
+{
+  uint32_t slot;
+  if (!m_freeSlots.empty())
+  {
+    slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    m_entries[slot] = {e, m_heap.size(), m_seq++};
+  }
+  else
+  {
+    slot = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back({e, m_heap.size(), m_seq++});
+  }
+
+  m_heap.push_back(slot);
+  if (e.arcNode != NULL_NODE && m_mode == CancelMode_e::EAGER)
+  {
+    if (e.arcNode >= m_arcSlots.size()) m_arcSlots.resize(e.arcNode + 1);
+    m_arcSlots[e.arcNode].push_back(slot);
+  }
+  siftUp(m_heap.size() - 1);
+}
+
+CloseEvent const& CloseEventQueue::top() const
+{
+  if (m_heap.empty()) throw std::runtime_error("Close event queue is empty");
+  return m_entries[m_heap.front()].event;
+}
+
+CloseEvent CloseEventQueue::pop()
+{
+  auto e = top();
+  removeAt(0);
+  return e;
+}
+
+void CloseEventQueue::erase(node_t arcNode)
+{
+  if (arcNode >= m_arcSlots.size()) return;
+  // removing an event unlinks it from slots
+  auto const& slots = m_arcSlots[arcNode];
+  while (!slots.empty())
+    removeAt(m_entries[slots.back()].heapPos);
+}
+
+void CloseEventQueue::cancel(node_t arcNode, NodeArena& rArena)
+{
+  if (arcNode == NULL_NODE) return;
+  if (m_mode == CancelMode_e::LAZY)
+    ++rArena[arcNode].generation;
+  else
+    erase(arcNode);
+}
+
+void CloseEventQueue::clear()
+{
+  m_entries.clear();
+  m_heap.clear();
+  m_freeSlots.clear();
+  m_arcSlots.clear();
+  m_seq = 0;
+}
+
+std::vector<CloseEvent> CloseEventQueue::toVector(NodeArena const& arena) const
+{
+  std::vector<CloseEvent> rslt;
+  rslt.reserve(m_heap.size());
+  for (auto&& slot : m_heap)
+  {
+    if (!isStale(m_entries[slot].event, arena))
+      rslt.push_back(m_entries[slot].event);
+  }
+  std::sort(rslt.begin(), rslt.end(), close_event_less_than());
+  return rslt;
+}
+
+bool CloseEventQueue::higher(uint32_t lhsSlot, uint32_t rhsSlot) const
+{
+  auto const& l = m_entries[lhsSlot];
+  auto const& r = m_entries[rhsSlot];
+  if (l.event.yval == r.event.yval) return l.seq < r.seq;
+  return l.event.yval > r.event.yval;
+}
+
+void CloseEventQueue::swapPos(size_t i, size_t j)
+{
+  std::swap(m_heap[i], m_heap[j]);
+  m_entries[m_heap[i]].heapPos = i;
+  m_entries[m_heap[j]].heapPos = j;
+}
+
+void CloseEventQueue::siftUp(size_t pos)
+{
+  while (pos > 0)
+  {
+    auto parent = (pos - 1) / 2;
+    if (!higher(m_heap[pos], m_heap[parent])) break;
+    swapPos(pos, parent);
+    pos = parent;
+  }
+}
+
+void CloseEventQueue::siftDown(size_t pos)
+{
+  auto n = m_heap.size();
+  while (true)
+  {
+    auto best = pos;
+    auto l = 2 * pos + 1;
+    auto r = l + 1;
+    if (l < n && higher(m_heap[l], m_heap[best])) best = l;
+    if (r < n && higher(m_heap[r], m_heap[best])) best = r;
+    if (best == pos) break;
+    swapPos(pos, best);
+    pos = best;
+  }
+}
+
+void CloseEventQueue::removeAt(size_t pos)
+{
+  auto slot = m_heap[pos];
+  auto last = m_heap.size() - 1;
+  if (pos != last)
+    swapPos(pos, last);
+  m_heap.pop_back();
+  if (pos < m_heap.size())
+  {
+    siftDown(pos);
+    siftUp(pos);
+  }
+
+  auto const& e = m_entries[slot].event;
+  if (e.arcNode != NULL_NODE && m_mode == CancelMode_e::EAGER)
+    unlinkSlot(e.arcNode, slot);
+  // clear the free slot
+  m_entries[slot].event = CloseEvent();
+  m_freeSlots.push_back(slot);
+}
+
+void CloseEventQueue::unlinkSlot(node_t arcNode, uint32_t slot)
+{
+  if (arcNode >= m_arcSlots.size()) return;
+  auto& slots = m_arcSlots[arcNode];
+  slots.erase(std::find(slots.begin(), slots.end(), slot));
+}
+
+} // namespace GVD_SCALAR_NS
@@ -0,0 +1,88 @@
+#ifndef CLOSE_EVENT_QUEUE_HH
+#define CLOSE_EVENT_QUEUE_HH
+
+#include "types.hh"
+
+#include <vector>
+
+// How close events of an arc are cancelled
+// EAGER - the pending event is erased from the queue
+// LAZY - the arc generation is bumped and the stale event is
+//        discarded when it reaches the top of the queue
+enum class CancelMode_e
+{
+  EAGER = 1,
+  LAZY = 2
+};
+
+namespace GVD_SCALAR_NS
+{
+
+//------------------------------------------------------------
+// CloseEventQueue
+// Indexed binary max-heap of close events keyed by yval.
+// The event with the largest yval (closest to the sweepline)
+// is on top. Each pending event keeps a stable slot so the
+// events belonging to an arc can be located and erased in
+// O(log n) without scanning the queue.
+// In LAZY mode the arc index is not maintained.
+//------------------------------------------------------------
+class CloseEventQueue
+{
+public:
+  explicit CloseEventQueue(CancelMode_e mode = CancelMode_e::EAGER);
+
+  void push(CloseEvent const& e);
+  CloseEvent const& top() const;
+  CloseEvent pop();
+
+  // Erase every pending close event of the arc, stale ones included
+  void erase(node_t arcNode);
+
+  // Cancel the pending close events of an arc using the queue mode,
+  // both modes leave none of them live
+  void cancel(node_t arcNode, NodeArena& rArena);
+
+  // True if the event was cancelled (or its arc released) after it was created
+  static bool isStale(CloseEvent const& e, NodeArena const& arena)
+  {
+    return e.arcNode != NULL_NODE && arena[e.arcNode].generation != e.generation;
+  }
+
+  CancelMode_e mode() const { return m_mode; }
+
+  bool empty() const { return m_heap.empty(); }
+  size_t size() const { return m_heap.size(); }
+  void clear();
+
+  // live pending events in ascending yval order
+  std::vector<CloseEvent> toVector(NodeArena const& arena) const;
+
+private:
+  struct Entry
+  {
+    CloseEvent event;
+    size_t heapPos;
+    uint64_t seq;
+  };
+
+  bool higher(uint32_t lhsSlot, uint32_t rhsSlot) const;
+  void swapPos(size_t i, size_t j);
+  void siftUp(size_t pos);
+  void siftDown(size_t pos);
+  void removeAt(size_t pos);
+  void unlinkSlot(node_t arcNode, uint32_t slot);
+
+  std::vector<Entry> m_entries; // slot storage
+  std::vector<uint32_t> m_heap; // heap of slot indices
+  std::vector<uint32_t> m_freeSlots;
+  // arc -> slots, indexed by handle so the lists keep their
+  // capacity when arena slots are reused
+  std::vector<std::vector<uint32_t>> m_arcSlots;
+  uint64_t m_seq;
+  CancelMode_e m_mode;
+};
+
+} // namespace GVD_SCALAR_NS
+
+#endif
@@ -0,0 +1,201 @@
+#include "crossings.hh"
+#include "predicates.hh"
+
+#include <algorithm>
+#include <set>
+
+namespace GVD_SCALAR_NS
+{
+
+namespace
+{
+  struct Segment
+  {
+    vec2 l; // lexicographically smaller end
+    vec2 r;
+    uint32_t polygon;
+  };
+
+  inline bool lexLess(vec2 const& a, vec2 const& b)
+  {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+  }
+
+  inline bool same(vec2 const& a, vec2 const& b)
+  {
+    return a.x == b.x && a.y == b.y;
+  }
+
+  inline int sign(decimal_t v)
+  {
+    return (v > 0.0) - (v < 0.0);
+  }
+
+  //------------------------------------------------------------
+  // SegmentLess
+  // Bottom to top order of the segments cut by the sweep line.
+  // The segment that starts later is placed against the line of
+  // the other, so the order holds for any two segments that do
+  // not cross, vertical ones included.
+  //------------------------------------------------------------
+  struct SegmentLess
+  {
+    std::vector<Segment> const* pSegments;
+
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+      if (a == b) return false;
+      auto const& s = (*pSegments)[a];
+      auto const& t = (*pSegments)[b];
+      if (lexLess(t.l, s.l))
+      {
+        auto o = sign(math::orient2d(t.l, t.r, s.l));
+        if (o == 0) o = sign(math::orient2d(t.l, t.r, s.r));
+        if (o != 0) return o < 0;
+      }
+      else
+      {
+        auto o = sign(math::orient2d(s.l, s.r, t.l));
+        if (o == 0) o = sign(math::orient2d(s.l, s.r, t.r));
+        if (o != 0) return o > 0;
+      }
+      // collinear, these overlap and are reported once neighbours
+      return a < b;
+    }
+  };
+
+  // edges of one polygon may meet at a shared end unless they
+  // run on along each other from there
+  bool crosses(Segment const& s, Segment const& t)
+  {
+    auto o1 = sign(math::orient2d(s.l, s.r, t.l));
+    auto o2 = sign(math::orient2d(s.l, s.r, t.r));
+    auto o3 = sign(math::orient2d(t.l, t.r, s.l));
+    auto o4 = sign(math::orient2d(t.l, t.r, s.r));
+    if (o1 * o2 > 0 || o3 * o4 > 0) return false;
+    auto collinear = o1 == 0 && o2 == 0;
+    if (collinear && (lexLess(s.r, t.l) || lexLess(t.r, s.l))) return false;
+    if (s.polygon != t.polygon) return true;
+
+    for (auto const* e : {&s.l, &s.r})
+    {
+      if (!same(*e, t.l) && !same(*e, t.r)) continue;
+      if (!collinear) return false;
+      auto const& sOther = e == &s.l ? s.r : s.l;
+      auto const& tOther = same(*e, t.l) ? t.r : t.l;
+      return lexLess(*e, sOther) == lexLess(*e, tOther);
+    }
+    return true;
+  }
+
+  struct SweepEvent
+  {
+    vec2 p;
+    uint32_t segment;
+    bool insert;
+  };
+}
+
+std::vector<crossing_t> findCrossings(std::vector<Polygon> const& polygons)
+{
+  std::vector<Segment> segments;
+  std::vector<uint32_t> firstSegment;
+  firstSegment.reserve(polygons.size() + 1);
+  for (uint32_t i = 0; i < polygons.size(); ++i)
+  {
+    firstSegment.push_back(static_cast<uint32_t>(segments.size()));
+    auto const& pts = polygons[i].orderedPointSites;
+    if (pts.size() < 2) continue;
+    auto count = pts.size() == 2 ? 1 : pts.size();
+    for (size_t k = 0; k < count; ++k)
+    {
+      auto const& a = pts[k].point;
+      auto const& b = pts[(k + 1) % pts.size()].point;
+      if (same(a, b)) continue;
+      segments.push_back(lexLess(a, b) ? Segment{a, b, i} : Segment{b, a, i});
+    }
+  }
+  firstSegment.push_back(static_cast<uint32_t>(segments.size()));
+
+  std::vector<SweepEvent> events;
+  events.reserve(segments.size() * 2);
+  for (uint32_t i = 0; i < segments.size(); ++i)
+  {
+    events.push_back({segments[i].l, i, true});
+    events.push_back({segments[i].r, i, false});
+  }
+  // segments starting at a point meet the ones ending there
+  std::sort(events.begin(), events.end(), [](SweepEvent const& a, SweepEvent const& b) {
+    if (!same(a.p, b.p)) return lexLess(a.p, b.p);
+    return a.insert && !b.insert;
+  });
+
+  typedef std::set<uint32_t, SegmentLess> active_t;
+  active_t active(SegmentLess{&segments});
+  std::vector<active_t::iterator> position(segments.size(), active.end());
+  std::vector<bool> dropped(polygons.size(), false);
+  std::vector<crossing_t> rslt;
+
+  std::vector<std::pair<uint32_t, uint32_t>> pending;
+  auto remove = [&](uint32_t s) {
+    auto it = position[s];
+    if (it != active.begin() && std::next(it) != active.end())
+      pending.push_back({*std::prev(it), *std::next(it)});
+    active.erase(it);
+    position[s] = active.end();
+  };
+  auto resolve = [&]() {
+    while (!pending.empty())
+    {
+      auto p = pending.back();
+      pending.pop_back();
+      if (position[p.first] == active.end() || position[p.second] == active.end()) continue;
+      auto const& s = segments[p.first];
+      auto const& t = segments[p.second];
+      if (!crosses(s, t)) continue;
+
+      auto keep = std::min(s.polygon, t.polygon);
+      auto drop = std::max(s.polygon, t.polygon);
+      rslt.push_back({polygons[keep].getLabel(), polygons[drop].getLabel()});
+      dropped[drop] = true;
+      for (auto i = firstSegment[drop]; i < firstSegment[drop + 1]; ++i)
+      {
+        if (position[i] != active.end()) remove(i);
+      }
+    }
+  };
+
+  for (auto&& e : events)
+  {
+    if (dropped[segments[e.segment].polygon]) continue;
+    if (e.insert)
+    {
+      auto it = active.insert(e.segment).first;
+      position[e.segment] = it;
+      if (it != active.begin()) pending.push_back({*std::prev(it), e.segment});
+      if (std::next(it) != active.end()) pending.push_back({e.segment, *std::next(it)});
+    }
+    else
+    {
+      remove(e.segment);
+    }
+    resolve();
+  }
+  return rslt;
+}
+
+std::vector<crossing_t> findCrossings(std::vector<Polygon>& rPolygons, bool repair)
+{
+  auto rslt = findCrossings(rPolygons);
+  if (!repair || rslt.empty()) return rslt;
+
+  std::vector<uint32_t> droppedLabels;
+  for (auto&& c : rslt) droppedLabels.push_back(c.second);
+  std::sort(droppedLabels.begin(), droppedLabels.end());
+  rPolygons.erase(std::remove_if(rPolygons.begin(), rPolygons.end(), [&droppedLabels](Polygon const& p) {
+    return std::binary_search(droppedLabels.begin(), droppedLabels.end(), p.getLabel());
+  }), rPolygons.end());
+  return rslt;
+}
+
+} // namespace GVD_SCALAR_NS
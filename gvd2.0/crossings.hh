@@ -0,0 +1,31 @@
+#ifndef CROSSINGS_HH
+#define CROSSINGS_HH
+
+#include "types.hh"
+
+#include <utility>
+#include <vector>
+
+namespace GVD_SCALAR_NS
+{
+
+// labels of two polygons with touching segments, the one kept
+// and the one set aside, equal for a polygon touching itself
+typedef std::pair<uint32_t, uint32_t> crossing_t;
+
+//------------------------------------------------------------
+// findCrossings
+// Segments of different polygons that cross, overlap or touch,
+// and segments of one polygon meeting anywhere but a shared end,
+// found with a Shamos-Hoey sweep on exact orientation tests in
+// O(n log n). The sweep is only ordered up to the first crossing,
+// so the later polygon of each crossing is set aside and the sweep
+// goes on without it. Dropping every second label leaves polygons
+// without crossings, repair does that in place.
+//------------------------------------------------------------
+std::vector<crossing_t> findCrossings(std::vector<Polygon> const& polygons);
+std::vector<crossing_t> findCrossings(std::vector<Polygon>& rPolygons, bool repair);
+
+} // namespace GVD_SCALAR_NS
+
+#endif
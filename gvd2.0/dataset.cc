@@ -1,14 +1,27 @@
 #include "dataset.hh"
+#include "marchingSquares.hh"
 #include "math.hh"
+#include "parallel.hh"
 #include "types.hh"
 
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <memory>
-#include <sstream>
+#include <stdexcept>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace GVD_SCALAR_NS
+{
+
 namespace
 {
 
@@ -29,115 +42,203 @@ namespace
 
   /////////////////////////// Helper Functions //////////////////////////////////////////
 
-  std::vector<std::string> split(const std::string& s, char delimiter)
+  //------------------------------------------------------------
+  // MappedFile
+  // Read only view of a whole file, unmapped on destruction.
+  // A file that can not be opened is not open(), an empty
+  // file is open with size 0.
+  //------------------------------------------------------------
+  class MappedFile
   {
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(s);
-    while (std::getline(tokenStream, token, delimiter))
+  public:
+    explicit MappedFile(std::string const& path) : m_data(nullptr), m_size(0), m_open(false)
+    {
+      auto fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) return;
+      struct stat st;
+      if (::fstat(fd, &st) == 0)
+      {
+        m_open = true;
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size > 0)
+        {
+          auto p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (p == MAP_FAILED)
+          {
+            m_open = false;
+            m_size = 0;
+          }
+          else
+          {
+            m_data = static_cast<char const*>(p);
+          }
+        }
+      }
+      ::close(fd);
+    }
+
+    ~MappedFile()
     {
-        tokens.push_back(token);
+      if (m_data) ::munmap(const_cast<char*>(m_data), m_size);
     }
-    return tokens;
-  }
 
-  vec2 parseLineToVec2(std::string const& s)
-  {
-    auto t = split(s, ' ');
-    return {std::stod(t[0]), std::stod(t[1])};
-  }
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
 
-  struct RemovedResult
-  {
-    bool removed;
-    std::vector<vec2> points;
+    bool open() const { return m_open; }
+    char const* begin() const { return m_data; }
+    char const* end() const { return m_data + m_size; }
+
+  private:
+    char const* m_data;
+    size_t m_size;
+    bool m_open;
   };
 
-  bool isColinear(vec2 const& p1,vec2 const& p2, vec2 const& p3, std::shared_ptr<decimal_t> pOptTolerance = nullptr)
+  typedef std::pair<char const*, char const*> line_t;
+
+  // lines as std::getline splits them - a last line without
+  // the newline only counts if it is not empty
+  void splitLines(MappedFile const& file, std::vector<line_t>& rLines)
   {
-    auto v1 = vec2(p2.x - p1.x, p2.y - p1.y);
-    auto v2 = vec2(p3.x - p1.x, p3.y - p1.y);
-    auto c = math::crossProduct(v1, v2);
-    if (pOptTolerance)
+    rLines.clear();
+    auto pos = file.begin();
+    auto end = file.end();
+    while (pos != end)
     {
-      return std::abs(c) < *pOptTolerance;
+      auto eol = std::find(pos, end, '\n');
+      rLines.push_back({pos, eol});
+      pos = eol == end ? end : eol + 1;
     }
+  }
 
-    return c == 0;
+  inline bool isBlank(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
   }
 
-  std::vector<size_t> getMatch(std::vector<vec2> const& dataPoints)
+  // parses the next number in [rPos, end) and moves rPos past it
+  bool parseDouble(char const*& rPos, char const* end, double& rValue)
+  {
+    while (rPos != end && isBlank(*rPos)) ++rPos;
+    if (rPos != end && *rPos == '+') ++rPos;
+    auto r = std::from_chars(rPos, end, rValue);
+    if (r.ec != std::errc()) return false;
+    rPos = r.ptr;
+    return true;
+  }
+
+  // "x y" line of a polygon file, the y token starts after the
+  // first space so "x, y" lines are read as well
+  vec2 parseLineToVec2(line_t const& line, std::string const& path)
+  {
+    double x, y;
+    auto pos = line.first;
+    auto ok = parseDouble(pos, line.second, x);
+    pos = std::find(pos, line.second, ' ');
+    if (!ok || !parseDouble(pos, line.second, y))
+      throw std::runtime_error("Invalid vertex in " + path + ": "
+                               + std::string(line.first, line.second));
+    return {x, y};
+  }
+
+  bool isColinear(vec2 const& p1,vec2 const& p2, vec2 const& p3, std::shared_ptr<decimal_t> pOptTolerance = nullptr)
   {
-    for (size_t i = 0; i < dataPoints.size(); i++)
+    if (pOptTolerance)
     {
-      size_t prevIdx = i == 0 ? dataPoints.size()-1 : i-1;
-      if (math::equivD(dataPoints[i].y, dataPoints[prevIdx].y))
-        return { prevIdx, i };
+      auto v1 = vec2(p2.x - p1.x, p2.y - p1.y);
+      auto v2 = vec2(p3.x - p1.x, p3.y - p1.y);
+      return math::abs(math::crossProduct(v1, v2)) < *pOptTolerance;
     }
-    return {};
+
+    return math::orient2d(p1, p2, p3) == 0;
   }
 
-  decimal_t getOffsetValue(std::vector<vec2> const& dataPoints, std::vector<size_t> const& match)
+  decimal_t getOffsetValue(std::vector<vec2> const& dataPoints, size_t prevIdx, size_t /* idx */)
   {
-    auto xDiff = std::abs(dataPoints[match[0]].x - dataPoints[match[0]].x);
+    auto xDiff = math::abs(dataPoints[prevIdx].x - dataPoints[prevIdx].x);
     auto value = xDiff * 0.007;
     if (value == 0.0) {return 1e-6;}
     return value;
   }
 
-  RemovedResult removeColinearPoints(std::vector<vec2> const& points, std::shared_ptr<decimal_t> pOptTolerance = nullptr)
+  // index of the point removed for the colinear triple prev, i, next
+  size_t colinearMiddle(std::vector<vec2> const& points, size_t prev, size_t i, size_t next)
   {
-    bool didRemove = false;
+    std::array<SortableVec2, 3> l{{{points[prev], prev}, {points[i], i}, {points[next], next}}};
+    std::sort(l.begin(), l.end(), vec2_less_than());
+    return l[1].idx;
+  }
+
+  //------------------------------------------------------------
+  // removeCAS
+  // Removes colinear points until none are left. Each pass tests
+  // every point against its neighbors and drops the middle point
+  // of each colinear triple. A triple whose points all survive a
+  // pass unchanged was not colinear, so after the first pass only
+  // the survivors next to a removed point are tested again. The
+  // points are kept in a circular list so a pass costs O(removed).
+  //------------------------------------------------------------
+  std::vector<vec2> removeCAS(std::vector<vec2> const& points, std::shared_ptr<decimal_t> pOptTolerance = nullptr)
+  {
+    auto n = points.size();
+    std::vector<size_t> prev(n), next(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      prev[i] = i == 0 ? n - 1 : i - 1;
+      next[i] = (i + 1) % n;
+    }
+    std::vector<char> alive(n, 1);
+    std::vector<char> queued(n, 1);
+    std::vector<size_t> toTest(n);
+    for (size_t i = 0; i < n; ++i) toTest[i] = i;
     std::vector<size_t> toRemove;
-    std::vector<vec2> afterRemove;
-
-    for (size_t i = 0; i < points.size(); i++) {
-      size_t start = i == 0 ? points.size()-1 : i-1;
-      size_t c = (i+1)%points.size();
-      auto p1 = points[start];
-      auto p2 = points[i];
-      auto p3 = points[c]; // 2,3,0
-      if (isColinear(p1, p2, p3, pOptTolerance))
+
+    while (!toTest.empty())
+    {
+      toRemove.clear();
+      for (auto i : toTest)
       {
-        std::vector<SortableVec2> l{{p1, start}, {p2, i}, {p3, c}};
-        std::sort(l.begin(), l.end(), vec2_less_than());
-        toRemove.push_back(l[1].idx);
+        queued[i] = 0;
+        if (isColinear(points[prev[i]], points[i], points[next[i]], pOptTolerance))
+          toRemove.push_back(colinearMiddle(points, prev[i], i, next[i]));
       }
-    }
 
-    if (toRemove.size() > 0) {
-      for (size_t j = 0; j < points.size(); ++j)
+      toTest.clear();
+      for (auto r : toRemove)
       {
-        if (std::find(toRemove.begin(), toRemove.end(), j) == toRemove.end())
+        if (!alive[r]) continue;
+        alive[r] = 0;
+        next[prev[r]] = next[r];
+        prev[next[r]] = prev[r];
+        for (auto neighbor : {prev[r], next[r]})
         {
-          // does not contain j
-          afterRemove.push_back(points[j]);
+          if (queued[neighbor]) continue;
+          queued[neighbor] = 1;
+          toTest.push_back(neighbor);
         }
       }
-
-      didRemove = true;
+      // neighbors removed later in the pass are not tested
+      toTest.erase(std::remove_if(toTest.begin(), toTest.end(),
+        [&alive](size_t i) { return !alive[i]; }), toTest.end());
     }
-    // place the ending back on
-    // add the start/end point if it does not create a colinear line
-    // if (isColinear(orderedPoints[orderedPoints.size()], finalPoint, orderedPoints[0]))
-    //   orderedPoints.push_back(finalPoint);
-    if (didRemove)
-      return {didRemove, afterRemove};
-    else
-      return {didRemove, points};
-  }
 
-  std::vector<vec2> removeCAS(std::vector<vec2> points, std::shared_ptr<decimal_t> pOptTolerance = nullptr)
-  {
-    auto rslt = removeColinearPoints(points, pOptTolerance);
-    while(rslt.removed)
+    std::vector<vec2> rslt;
+    for (size_t i = 0; i < n; ++i)
     {
-      rslt = removeColinearPoints(rslt.points, pOptTolerance);
+      if (alive[i]) rslt.push_back(points[i]);
     }
-    return rslt.points;
+    return rslt;
   }
 }
 
+//------------------------------------------------------------
+// sanitizeData
+// Drops colinear points and lowers one end of every horizontal
+// edge. Edges are fixed from the first vertex on, lowering a
+// point only changes the edges on either side of it so the scan
+// steps back one vertex instead of starting over.
+//------------------------------------------------------------
 std::vector<vec2> sanitizeData(std::vector<vec2>& orderedPoints, std::shared_ptr<decimal_t> pOptTolerance = nullptr)
 {
   if (orderedPoints.size() > 3)
@@ -146,78 +247,292 @@ std::vector<vec2> sanitizeData(std::vector<vec2>& orderedPoints, std::shared_ptr
   }
 
   if (orderedPoints.size() < 2) return orderedPoints;
-  auto match = getMatch(orderedPoints);
-  while(match.size() > 0)
+  auto n = orderedPoints.size();
+  size_t i = 0;
+  while (i < n)
   {
-    orderedPoints[match[0]].y -= getOffsetValue(orderedPoints, match);
-    match = getMatch(orderedPoints);
+    size_t prevIdx = i == 0 ? n - 1 : i - 1;
+    if (!math::equivD(orderedPoints[i].y, orderedPoints[prevIdx].y))
+    {
+      ++i;
+      continue;
+    }
+    orderedPoints[prevIdx].y -= getOffsetValue(orderedPoints, prevIdx, i);
+    if (i > 0) --i;
   }
   return orderedPoints;
 }
 
-std::vector<Polygon> processInputFiles(std::string const& inputFiles)
+namespace
 {
-  std::ifstream fin(inputFiles.c_str());
+  // polygon points of the unique points of a polygon file
+  std::vector<vec2> sanitizePolygon(std::vector<vec2>& uniquePoints)
+  {
+    if (uniquePoints.empty()) return {};
+    auto uPts = sanitizeData(uniquePoints);
+    if (uPts.empty()) return {};
 
-  // each file is a single polygon, line, or point
-  std::vector<Polygon> polygons;
-  std::string filePath;
-  while(fin >> filePath)
-  {
-    // std::cout << "File path:" << filePath << std::endl;
-    if (filePath.empty()) continue;
-    // trim?
-    // each file of format
-    // xxxxx yyyyyyy - p1
-    // xxxxx yyyyyyy...
-    // xxxxx yyyyyyy - p1
-    std::ifstream file(filePath.c_str());
-    std::string line;
-    std::vector<std::string> lines;
-    while (std::getline(file, line))
+    // we assume point sets greater than 2 are a closed polygon
+    if (uPts.size() > 2)
+      return uPts;
+    else if (uPts.size() == 2 && !math::equiv2(uPts[0], uPts[1]))
+      return uPts;
+    else if (uPts.size() == 1 || math::equiv2(uPts[0], uPts[1]))
+      return {uPts[0]};
+    return {};
+  }
+
+  // site events are created here, on one thread and in polygon
+  // order, so labels and event ids do not depend on the threads
+  std::vector<Polygon> createPolygons(std::vector<std::vector<vec2>> const& polygonPoints)
+  {
+    std::vector<Polygon> polygons;
+    polygons.reserve(polygonPoints.size());
+    auto label = reserveLabels(static_cast<uint32_t>(polygonPoints.size()));
+    for (auto&& points : polygonPoints)
     {
-      lines.push_back(line);
+      polygons.push_back(Polygon(label++));
+      for (auto&& p : points) polygons.back().addPoint(p);
     }
-    Polygon poly;
+    return polygons;
+  }
 
-    if (lines.size() == 2)
+  // calls f with every path of a file list, paths are separated by any whitespace
+  template <typename F>
+  void forEachPolygonFile(MappedFile const& list, F f)
+  {
+    std::string filePath;
+    auto pos = list.begin();
+    while (pos != list.end())
     {
-      poly.addPoint(parseLineToVec2(lines[0]));
+      auto start = std::find_if_not(pos, list.end(), isBlank);
+      pos = std::find_if(start, list.end(), isBlank);
+      if (start == pos) continue;
+      filePath.assign(start, pos);
+      f(filePath);
     }
-    else
+  }
+
+  // unique points of a polygon file of format
+  // xxxxx yyyyyyy - p1
+  // xxxxx yyyyyyy...
+  // xxxxx yyyyyyy - p1
+  void readPolygonFile(std::string const& filePath, std::vector<line_t>& rLines,
+                       std::vector<vec2>& rUniquePoints)
+  {
+    MappedFile file(filePath);
+    if (!file.open())
+      throw std::runtime_error("Unable to read " + filePath);
+    splitLines(file, rLines);
+    if (rLines.empty())
+      throw std::runtime_error("Empty polygon file " + filePath);
+
+    rUniquePoints.clear();
+    // skip the last line since it is the same as the first,
+    // a two line file is a single point
+    auto count = rLines.size() == 2 ? 1 : rLines.size() - 1;
+    for (size_t i = 0; i < count; ++i)
     {
+      rUniquePoints.push_back(parseLineToVec2(rLines[i], filePath));
+    }
+  }
+
+  //------------------------------------------------------------
+  // Scene file, see convertToScene. Native byte order:
+  // SceneHeader
+  // uint64_t offsets[polygonCount + 1] - first vertex of each polygon
+  // double coords[2 * vertexCount] - x y of each vertex
+  // Every section is 8 byte aligned so a mapped scene is read
+  // in place.
+  //------------------------------------------------------------
+  const char g_sceneMagic[8] = {'G', 'V', 'D', 'S', 'C', 'E', 'N', 'E'};
+  const uint32_t SCENE_VERSION = 1;
+
+  struct SceneHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t polygonCount;
+    uint64_t vertexCount;
+  };
+
+  bool isScene(MappedFile const& file)
+  {
+    return file.open() && static_cast<size_t>(file.end() - file.begin()) >= sizeof(g_sceneMagic)
+      && std::equal(g_sceneMagic, g_sceneMagic + sizeof(g_sceneMagic), file.begin());
+  }
+
+  std::vector<Polygon> readScene(MappedFile const& file, std::string const& path, size_t& rVertexCount)
+  {
+    auto size = static_cast<size_t>(file.end() - file.begin());
+    if (size < sizeof(SceneHeader))
+      throw std::runtime_error("Truncated scene " + path);
+    auto const* header = reinterpret_cast<SceneHeader const*>(file.begin());
+    if (header->version != SCENE_VERSION)
+      throw std::runtime_error("Unsupported scene version " + std::to_string(header->version) + " in " + path);
+
+    auto offsetsSize = (static_cast<size_t>(header->polygonCount) + 1) * sizeof(uint64_t);
+    // compared against what is left so a corrupt count cannot wrap
+    if (size < sizeof(SceneHeader) + offsetsSize
+        || header->vertexCount > (size - sizeof(SceneHeader) - offsetsSize) / (2 * sizeof(double)))
+      throw std::runtime_error("Truncated scene " + path);
+    auto const* offsets = reinterpret_cast<uint64_t const*>(file.begin() + sizeof(SceneHeader));
+    auto const* coords = reinterpret_cast<double const*>(file.begin() + sizeof(SceneHeader) + offsetsSize);
+
+    std::vector<std::vector<vec2>> polygonPoints(header->polygonCount);
+    parallelFor(polygonPoints.size(), [&](size_t i) {
+      if (offsets[i] > offsets[i + 1] || offsets[i + 1] > header->vertexCount)
+        throw std::runtime_error("Invalid polygon offsets in scene " + path);
       std::vector<vec2> uniquePoints;
-      // skip the first line since it is the same as the last
-      for (size_t i = 0; i < lines.size() - 1; ++i)
-      {
-        uniquePoints.push_back(parseLineToVec2(lines[i]));
-      }
+      uniquePoints.reserve(offsets[i + 1] - offsets[i]);
+      for (auto v = offsets[i]; v < offsets[i + 1]; ++v)
+        uniquePoints.push_back(vec2(coords[2 * v], coords[2 * v + 1]));
+      polygonPoints[i] = sanitizePolygon(uniquePoints);
+    });
+    rVertexCount = header->vertexCount;
+    return createPolygons(polygonPoints);
+  }
 
-      // auto uPts = uniquePoints;
-      auto uPts = sanitizeData(uniquePoints);
+  //------------------------------------------------------------
+  // Grid map, the MovingAI octile format
+  // type octile
+  // height H
+  // width W
+  // map
+  // H rows of W cells, '.', 'G' and 'S' are passable
+  //------------------------------------------------------------
+  bool isMap(MappedFile const& file)
+  {
+    const std::string magic = "type ";
+    return file.open() && static_cast<size_t>(file.end() - file.begin()) >= magic.size()
+      && std::equal(magic.begin(), magic.end(), file.begin());
+  }
 
-      // we assume point sets greater than 2 are a closed polygon
-      if (uPts.size() > 2)
-      {
-        for (size_t i = 0; i < uPts.size(); ++i)
-        {
-          poly.addPoint(uPts[i]);
-        }
-      }
-      else if (uPts.size() == 2 && !math::equiv2(uPts[0], uPts[1]))
+  std::vector<Polygon> readMap(MappedFile const& file, std::string const& path, size_t& rVertexCount)
+  {
+    std::vector<line_t> lines;
+    splitLines(file, lines);
+
+    size_t width = 0, height = 0, row = 0;
+    for (; row < lines.size(); ++row)
+    {
+      std::string line(lines[row].first, lines[row].second);
+      while (!line.empty() && isBlank(line.back())) line.pop_back();
+      if (line == "map") break;
+      auto space = line.find(' ');
+      if (space == std::string::npos) continue;
+      auto key = line.substr(0, space);
+      if (key == "height") height = std::stoul(line.substr(space + 1));
+      else if (key == "width") width = std::stoul(line.substr(space + 1));
+    }
+    if (width == 0 || height == 0 || lines.size() < row + 1 + height)
+      throw std::runtime_error("Invalid map header in " + path);
+
+    std::vector<uint8_t> blocked(width * height);
+    for (size_t r = 0; r < height; ++r)
+    {
+      auto const& line = lines[row + 1 + r];
+      if (static_cast<size_t>(line.second - line.first) < width)
+        throw std::runtime_error("Short map row " + std::to_string(r) + " in " + path);
+      for (size_t c = 0; c < width; ++c)
       {
-        poly.addPoint(uPts[0]);
-        poly.addPoint(uPts[1]);
+        auto cell = line.first[c];
+        blocked[r * width + c] = cell != '.' && cell != 'G' && cell != 'S';
       }
-      else if (uPts.size() == 1 || math::equiv2(uPts[0], uPts[1]))
+    }
+    auto contours = traceContours(blocked, width, height);
+
+    // turned slightly about the grid corner so few edges are axis
+    // aligned, then scaled to [-1, 1] with y up, as canvasToPolygons
+    // in dataset.js does with the canvas pixels
+    const double theta = -0.02;
+    auto cosT = std::cos(theta), sinT = std::sin(theta);
+    std::vector<std::vector<vec2>> polygonPoints(contours.size());
+    parallelFor(contours.size(), [&](size_t i) {
+      std::vector<vec2> uniquePoints;
+      uniquePoints.reserve(contours[i].size());
+      for (auto&& g : contours[i])
       {
-        poly.addPoint(uPts[0]);
+        auto x = g.x * cosT - g.y * sinT;
+        auto y = g.x * sinT + g.y * cosT;
+        uniquePoints.push_back(vec2(2.0 * x / width - 1.0, 1.0 - 2.0 * y / height));
       }
+      polygonPoints[i] = sanitizePolygon(uniquePoints);
+    });
+    for (auto&& c : contours) rVertexCount += c.size();
+    return createPolygons(polygonPoints);
+  }
+}
+
+std::vector<Polygon> processInputFiles(std::string const& inputFiles)
+{
+  size_t vertexCount;
+  return processInputFiles(inputFiles, vertexCount);
+}
+
+std::vector<Polygon> processInputFiles(std::string const& inputFiles, size_t& rVertexCount)
+{
+  rVertexCount = 0;
+  MappedFile list(inputFiles);
+  if (!list.open())
+    throw std::runtime_error("Unable to read " + inputFiles);
+  if (isScene(list))
+    return readScene(list, inputFiles, rVertexCount);
+  if (isMap(list))
+    return readMap(list, inputFiles, rVertexCount);
+
+  // each file is a single polygon, line, or point
+  std::vector<std::string> paths;
+  forEachPolygonFile(list, [&paths](std::string const& filePath) { paths.push_back(filePath); });
+
+  // polygons are independent until createDataQueue
+  std::vector<std::vector<vec2>> polygonPoints(paths.size());
+  std::vector<size_t> vertexCounts(paths.size());
+  parallelFor(paths.size(), [&](size_t i) {
+    thread_local std::vector<line_t> lines;
+    std::vector<vec2> uniquePoints;
+    readPolygonFile(paths[i], lines, uniquePoints);
+    vertexCounts[i] = uniquePoints.size();
+    polygonPoints[i] = sanitizePolygon(uniquePoints);
+  });
+  for (auto&& c : vertexCounts) rVertexCount += c;
+  return createPolygons(polygonPoints);
+}
+
+size_t convertToScene(std::string const& inputFiles, std::string const& scenePath)
+{
+  MappedFile list(inputFiles);
+  if (!list.open())
+    throw std::runtime_error("Unable to read " + inputFiles);
+
+  std::vector<uint64_t> offsets = {0};
+  std::vector<double> coords;
+  std::vector<line_t> lines;
+  std::vector<vec2> uniquePoints;
+  forEachPolygonFile(list, [&](std::string const& filePath) {
+    readPolygonFile(filePath, lines, uniquePoints);
+    for (auto&& p : uniquePoints)
+    {
+      // parsed as double, see parseLineToVec2
+      coords.push_back(static_cast<double>(p.x));
+      coords.push_back(static_cast<double>(p.y));
     }
+    offsets.push_back(offsets.back() + uniquePoints.size());
+  });
 
-    polygons.push_back(poly);
-  }
-  return polygons;
+  SceneHeader header;
+  std::copy(g_sceneMagic, g_sceneMagic + sizeof(header.magic), header.magic);
+  header.version = SCENE_VERSION;
+  header.polygonCount = static_cast<uint32_t>(offsets.size() - 1);
+  header.vertexCount = offsets.back();
+
+  std::ofstream ofs(scenePath.c_str(), std::ofstream::out | std::ofstream::binary | std::ios_base::trunc);
+  ofs.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  ofs.write(reinterpret_cast<char const*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+  ofs.write(reinterpret_cast<char const*>(coords.data()), coords.size() * sizeof(double));
+  if (!ofs)
+    throw std::runtime_error("Unable to write " + scenePath);
+  return header.polygonCount;
 }
 
 // std::vector<Polygon> getTestSet()
@@ -242,3 +557,5 @@ std::vector<Polygon> processInputFiles(std::string const& inputFiles)
 
 //   return rslt;
 // }
+
+} // namespace GVD_SCALAR_NS
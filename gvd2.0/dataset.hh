@@ -1,13 +1,29 @@
 #ifndef DATASET_HH
 #define DATASET_HH
 
+#include "scalar.hh"
+
 #include <string>
 #include <vector>
 
+namespace GVD_SCALAR_NS
+{
+
 class Polygon;
 
+// reads the polygon files listed in inputFiles, a scene file
+// written by convertToScene or a MovingAI grid map (.map)
 std::vector<Polygon> processInputFiles(std::string const& inputFiles);
+// same, counting the vertices read
+std::vector<Polygon> processInputFiles(std::string const& inputFiles, size_t& rVertexCount);
+
+// packs the polygon files listed in inputFiles into one binary scene
+// file so large datasets load with a single mapping, returns the
+// number of polygons written
+size_t convertToScene(std::string const& inputFiles, std::string const& scenePath);
 
 // std::vector<Polygon> getTestSet();
 
+} // namespace GVD_SCALAR_NS
+
 #endif
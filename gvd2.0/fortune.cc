@@ -2,34 +2,39 @@
 #include "dataset.hh"
 #include "math.hh"
 #include "nodeInsert.hh"
+#include "parallel.hh"
 #include "utils.hh"
 
 #include <fstream>
+#include <functional>
 #include <limits>
 #include <iomanip>
 
+namespace GVD_SCALAR_NS
+{
+
 namespace
 {
-  static std::shared_ptr<Node> root = nullptr;
-  static std::vector<std::pair<vec2, vec2>> g_edges;
-  static std::vector<std::vector<vec2>> g_curvedEdges;
+  // close events created by a single add or remove
+  typedef FixedVec<CloseEvent, 6> newCloseEvents_t;
 
-  EventPacket getEventPacket(Event const& e, std::vector<Event>& rQueue)
+  // The queue is never modified, rRemaining is the number of unprocessed
+  // events and the next event is at rRemaining - 1
+  EventPacket getEventPacket(Event const& e, std::vector<Event> const& queue, size_t& rRemaining)
   {
-    auto n = rQueue.back(); // right
-    auto nn = rQueue[rQueue.size() - 2]; // left
-    if (nn.type == EventType_e::SEG && n.type == EventType_e::SEG)
+    if (rRemaining == 0) return {e, {}};
+    auto const& n = queue[rRemaining - 1]; // right
+    if (rRemaining > 1 && n.type == EventType_e::SEG && queue[rRemaining - 2].type == EventType_e::SEG)
     {
+      auto const& nn = queue[rRemaining - 2]; // left
       EventPacket ret = {e, {nn, n}};
-      rQueue.pop_back();
-      rQueue.pop_back();
+      rRemaining -= 2;
       return ret;
     }
     else if (n.type == EventType_e::SEG)
     {
       EventPacket ret = {e, {n}};
-      // rQueue.erase(n);
-      rQueue.pop_back();
+      rRemaining -= 1;
       return ret;
     }
     return {e, {}};
@@ -42,36 +47,36 @@ namespace
     return diff > 2e-2;
   }
 
-  decimal_t getRadius(vec2 point, std::shared_ptr<Node> const& pl, std::shared_ptr<Node> const& pNode,
-                    std::shared_ptr<Node> const& pr)
+  decimal_t getRadius(vec2 point, Node const& pl, Node const& pNode,
+                    Node const& pr)
   {
-    if (pl->aType == ArcType_e::ARC_V && pNode->aType == ArcType_e::ARC_V && pr->aType == ArcType_e::ARC_V)
+    if (pl.aType == ArcType_e::ARC_V && pNode.aType == ArcType_e::ARC_V && pr.aType == ArcType_e::ARC_V)
     {
       return std::min(
-        std::min(math::distLine(point, pl->a, pl->b), math::distLine(point, pNode->a, pNode->b)),
-        math::distLine(point, pr->a, pr->b));
+        std::min(math::distLine(point, pl.a, pl.b), math::distLine(point, pNode.a, pNode.b)),
+        math::distLine(point, pr.a, pr.b));
     }
-    if (pl->aType == ArcType_e::ARC_PARA)
-      return math::dist(point, pl->point);
-    else if (pNode->aType == ArcType_e::ARC_PARA)
-      return math::dist(point, pNode->point);
+    if (pl.aType == ArcType_e::ARC_PARA)
+      return math::dist(point, pl.point);
+    else if (pNode.aType == ArcType_e::ARC_PARA)
+      return math::dist(point, pNode.point);
 
-    return math::dist(point, pr->point);
+    return math::dist(point, pr.point);
   }
 
-  std::shared_ptr<vec2> getIntercept(std::shared_ptr<Node> const& l, std::shared_ptr<Node> const& r, double directrix)
+  std::optional<vec2> getIntercept(Node const& l, Node const& r, double directrix)
   {
-    if (l->aType == ArcType_e::ARC_V && r->aType == ArcType_e::ARC_V)
+    if (l.aType == ArcType_e::ARC_V && r.aType == ArcType_e::ARC_V)
       return intersectStraightArcs(l, r, directrix);
-    else if (l->aType == ArcType_e::ARC_PARA && r->aType == ArcType_e::ARC_PARA)
+    else if (l.aType == ArcType_e::ARC_PARA && r.aType == ArcType_e::ARC_PARA)
       return intersectParabolicArcs(l, r, directrix);
 
     // if one is the endpoint of the other
     return intersectParabolicToStraightArc(l, r, directrix);
   }
 
-  decimal_t getDiff(std::shared_ptr<Node> const& pl, std::shared_ptr<Node> const& pNode,
-                    std::shared_ptr<Node> const& pr, vec2 p, double directrix)
+  decimal_t getDiff(Node const& pl, Node const& pNode,
+                    Node const& pr, vec2 p, double directrix)
   {
     auto radius = getRadius(p, pl, pNode, pr);
     auto newY = p.y - radius;
@@ -83,17 +88,17 @@ namespace
     auto i0 = getIntercept(pl, pNode, newY);
     auto i1 = getIntercept(pNode, pr, newY);
     if (!i0 || !i1) return 1e10;
-    auto diffX = std::abs(i0->x - i1->x);
-    auto diffY = std::abs(i0->y - i1->y);
+    auto diffX = math::abs(i0->x - i1->x);
+    auto diffY = math::abs(i0->y - i1->y);
     return diffX + diffY;
   }
 
-  std::shared_ptr<vec2> chooseClosePoint(std::shared_ptr<Node> const& pl, std::shared_ptr<Node> const& pNode,
-                  std::shared_ptr<Node> const& pr, std::vector<vec2> points, double directrix)
+  std::optional<vec2> chooseClosePoint(Node const& pl, Node const& pNode,
+                  Node const& pr, candidates_t const& points, double directrix)
   {
-    if (points.size() == 1) return std::make_shared<vec2>(points[0]);
+    if (points.size() == 1) return points[0];
     auto leastDiff = 10000;
-    size_t curIdx;
+    size_t curIdx = 0;
     // length test - the length of node's arc should be close to 0
     // for the correct point
     for (size_t i = 0; i < points.size(); i++)
@@ -106,17 +111,17 @@ namespace
       }
     }
 
-    if (!validDiff(leastDiff)) return nullptr;
-    return std::make_shared<vec2>(points[curIdx]);
+    if (!validDiff(leastDiff)) return std::nullopt;
+    return points[curIdx];
   }
 
-  std::vector<vec2> consolidate(std::vector<vec2> const& intersections, decimal_t pivotX)
+  candidates_t consolidate(candidates_t const& intersections, decimal_t pivotX)
   {
-    std::vector<vec2> ret;
+    candidates_t ret;
     // WATCH VALUE
     auto thresh = 0.000001;
-    std::vector<vec2> left;
-    std::vector<vec2> right;
+    candidates_t left;
+    candidates_t right;
     for (auto&& i : intersections)
     {
       if (i.x < pivotX)
@@ -164,65 +169,59 @@ namespace
 
   // Commits the final edge points for the closing edge
   // Assumes that edge->drawpoints[0] aka start is set
-  void commitEdge(std::shared_ptr<Node> edge, vec2 const& endPoint)
+  void commitEdge(node_t edge, vec2 const& endPoint, NodeArena& rArena, math::BisectorCache& rBisectors,
+                  std::vector<std::pair<vec2, vec2>>& rEdges,
+                  std::vector<std::vector<vec2>>& rCurvedEdges)
   {
-    auto prev = edge->prevArc();
-    auto next = edge->nextArc();
-    if (!prev || !next) return;
+    auto prev = rArena.prevArc(edge);
+    auto next = rArena.nextArc(edge);
+    if (prev == NULL_NODE || next == NULL_NODE) return;
 
     // only resolve general edges between labeled sites
-    if (prev->label == next->label) return;
+    if (rArena[prev].label == rArena[next].label) return;
     // create a bisector from the two sites
-    auto prevEvent = math::createEventFromNode(prev);
-    auto nextEvent = math::createEventFromNode(next);
+    auto prevEvent = math::createEventFromNode(rArena[prev]);
+    auto nextEvent = math::createEventFromNode(rArena[next]);
 
+    auto const& edgeStart = rArena[edge].edgeStart;
     if (prevEvent.type == EventType_e::SEG && nextEvent.type == EventType_e::SEG)
     {
-      g_edges.push_back({edge->edgeStart, endPoint});
+      rEdges.push_back({edgeStart, endPoint});
     }
     else
     {
-      auto b = math::bisect(prevEvent, nextEvent);
-      auto pts = getDrawPointsFromBisector(edge->edgeStart, endPoint, b);
+      auto const& b = rBisectors.get(prevEvent, nextEvent, rArena[edge].bisector);
+      auto pts = getDrawPointsFromBisector(edgeStart, endPoint, b);
       if (b.isLine)
-        g_edges.push_back({pts[0], pts[1]});
+        rEdges.push_back({pts[0], pts[1]});
       else
-        g_curvedEdges.push_back(pts);
+        rCurvedEdges.push_back(pts);
     }
   }
 
   // TODO optimize for intersect sharing
-  void setBeachline(std::shared_ptr<Node> const& pNode, ComputeResult& rslt, double const& sweepline)
+  void setBeachline(node_t n, NodeArena const& arena, ComputeResult& rslt, double const& sweepline)
   {
-    if (!pNode) return;
-    if (pNode->visited) return;
-    if (pNode->aType == ArcType_e::EDGE)
+    if (n == NULL_NODE) return;
+    auto const& node = arena[n];
+    if (node.aType == ArcType_e::EDGE)
     {
-      pNode->visited = true;
-      if (pNode->pLeft) setBeachline(pNode->pLeft, rslt, sweepline);
-      if (pNode->pRight) setBeachline(pNode->pRight, rslt, sweepline);
+      setBeachline(node.left, arena, rslt, sweepline);
+      setBeachline(node.right, arena, rslt, sweepline);
       return;
     }
-    else if (pNode->aType == ArcType_e::ARC_PARA)
+    else if (node.aType == ArcType_e::ARC_PARA)
     {
-      auto p = math::createParabola(pNode->point, sweepline, 0);
-      decimal_t x0;
-      decimal_t x1;
-      auto l = pNode->prevArc();
-      auto r = pNode->nextArc();
-      if (!l)
-      {
-        auto yDiff = std::abs(pNode->point.y - sweepline);
-        x0 = pNode->point.x - yDiff * 2.0;
-      }
-      if (!r)
-      {
-        auto yDiff = std::abs(pNode->point.y - sweepline);
-        x1 = pNode->point.x + yDiff * 2.0;
-      }
-
-      auto o = l ? getIntercept(l, pNode, sweepline) : nullptr;
-      auto d = r ? getIntercept(pNode, r, sweepline) : nullptr;
+      auto p = math::createParabola(node.point, sweepline, 0);
+      // fallback bounds for the outer arcs or a failed intercept
+      auto yDiff = math::abs(node.point.y - sweepline);
+      decimal_t x0 = node.point.x - yDiff * 2.0;
+      decimal_t x1 = node.point.x + yDiff * 2.0;
+      auto l = arena.prevArc(n);
+      auto r = arena.nextArc(n);
+
+      auto o = l != NULL_NODE ? getIntercept(arena[l], node, sweepline) : std::nullopt;
+      auto d = r != NULL_NODE ? getIntercept(node, arena[r], sweepline) : std::nullopt;
       auto xl = o ? o->x : x0;
       auto xr = d ? d->x : x1;
 
@@ -235,29 +234,20 @@ namespace
       auto pts = prepDraw(p, xl, xr);
       if (!pts.empty())
         rslt.b_curvedEdges.push_back(pts);
-      pNode->visited = true;
       return;
     }
-    else if (pNode->aType == ArcType_e::ARC_V)
+    else if (node.aType == ArcType_e::ARC_V)
     {
-      auto v = math::createV(pNode->a, pNode->b, sweepline, 0);
-      decimal_t x0;
-      decimal_t x1;
-      auto l = pNode->prevArc();
-      auto r = pNode->nextArc();
-      if (!l)
-      {
-        auto yDiff = std::abs(pNode->a.y - sweepline);
-        x0 = v.point.x - yDiff * 2.0;
-      }
-      if (!r)
-      {
-        auto yDiff = std::abs(pNode->a.y - sweepline);
-        x1 = v.point.x + yDiff * 2.0;
-      }
-
-      auto o = l ? getIntercept(l, pNode, sweepline) : nullptr;
-      auto d = r ? getIntercept(pNode, r, sweepline) : nullptr;
+      auto v = math::createV(node, sweepline, 0);
+      // fallback bounds for the outer arcs or a failed intercept
+      auto yDiff = math::abs(node.a.y - sweepline);
+      decimal_t x0 = v.point.x - yDiff * 2.0;
+      decimal_t x1 = v.point.x + yDiff * 2.0;
+      auto l = arena.prevArc(n);
+      auto r = arena.nextArc(n);
+
+      auto o = l != NULL_NODE ? getIntercept(arena[l], node, sweepline) : std::nullopt;
+      auto d = r != NULL_NODE ? getIntercept(node, arena[r], sweepline) : std::nullopt;
       auto xl = o ? o->x : x0;
       auto xr = d ? d->x : x1;
 
@@ -270,8 +260,6 @@ namespace
       auto pts = prepDraw(v, xl, xr);
       if (!pts.empty())
         rslt.b_edges.push_back(pts);
-
-      pNode->visited = true;
       return;
     }
 
@@ -279,121 +267,306 @@ namespace
   }
 }
 
-void writeResults(ComputeResult const& r, std::string const& ePath)
+//------------------------------------------------------------
+// beachlineDepth
+// Max and average depth of the arcs in the beachline, the
+// root is at depth 0
+//------------------------------------------------------------
+void beachlineDepth(node_t root, NodeArena const& arena, size_t& rMaxDepth, double& rAvgDepth)
 {
-  // write edges
-  std::ofstream outE(ePath.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
-  for (auto&& e: r.edges)
+  rMaxDepth = 0;
+  rAvgDepth = 0.0;
+  if (root == NULL_NODE) return;
+
+  size_t arcs = 0;
+  size_t depthSum = 0;
+  std::vector<std::pair<node_t, size_t>> stack = {{root, 0}};
+  while (!stack.empty())
+  {
+    auto n = stack.back();
+    stack.pop_back();
+    auto const& node = arena[n.first];
+    if (node.aType == ArcType_e::EDGE)
+    {
+      stack.push_back({node.left, n.second + 1});
+      stack.push_back({node.right, n.second + 1});
+      continue;
+    }
+    ++arcs;
+    depthSum += n.second;
+    rMaxDepth = std::max(rMaxDepth, n.second);
+  }
+  rAvgDepth = static_cast<double>(depthSum) / arcs;
+}
+
+namespace
+{
+  //------------------------------------------------------------
+  // TextFile
+  // A result file formatted in memory with math::toChars and
+  // written with one call, every number with the full precision
+  // of decimal_t.
+  //------------------------------------------------------------
+  class TextFile
+  {
+  public:
+    explicit TextFile(size_t points) : m_data(), m_precision(math::digits10() + 1)
+    {
+      m_data.reserve(points * 2 * (m_precision + 8) + 64);
+    }
+
+    void tag(char const* t)
+    {
+      m_data += t;
+    }
+
+    void number(decimal_t v)
+    {
+      char buf[64];
+      m_data.append(buf, math::toChars(buf, buf + sizeof(buf), v, m_precision));
+    }
+
+    void point(vec2 const& p)
+    {
+      number(p.x);
+      m_data += ' ';
+      number(p.y);
+      m_data += '\n';
+    }
+
+    void write(std::string const& path) const
+    {
+      std::ofstream ofs(path.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+      ofs.write(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+      if (!ofs)
+        throw std::runtime_error("Unable to write " + path);
+    }
+
+  private:
+    std::string m_data;
+    int m_precision;
+  };
+
+  template <typename Lines>
+  size_t pointCount(Lines const& lines)
   {
-    outE << "e\n"; // signal for new edge
-    outE << e.first.x << " " << e.first.y << std::endl;
-    outE << e.second.x << " " << e.second.y << std::endl;
+    size_t n = 0;
+    for (auto&& l : lines) n += l.size();
+    return n;
   }
 
-  for (auto&& ce: r.curvedEdges)
+  void writeEdges(ComputeResult const& r, std::string const& path)
   {
-    outE << "ec\n"; // signal for new edge
-    for (auto&& ePt : ce)
+    TextFile out(r.edges.size() * 2 + pointCount(r.curvedEdges));
+    for (auto&& e: r.edges)
+    {
+      out.tag("e\n"); // signal for new edge
+      out.point(e.first);
+      out.point(e.second);
+    }
+    for (auto&& ce: r.curvedEdges)
     {
-      outE << ePt.x << " " << ePt.y << std::endl;
+      out.tag("ec\n"); // signal for new edge
+      for (auto&& ePt : ce) out.point(ePt);
     }
+    out.tag("e");
+    out.write(path);
   }
-  outE << "e";
-  outE.close();
-}
 
-void writeResults(ComputeResult const& r, std::string const& ePath, std::string const& bPath)
-{
-  // write edges
-  writeResults(r, ePath);
+  void writeBeachline(ComputeResult const& r, std::string const& path)
+  {
+    TextFile out(pointCount(r.b_edges) + pointCount(r.b_curvedEdges));
+    for (auto&& e: r.b_edges)
+    {
+      out.tag("b\n"); // signal for new edge
+      for (auto&& ePt : e) out.point(ePt);
+    }
+    for (auto&& ce: r.b_curvedEdges)
+    {
+      out.tag("bc\n"); // signal for new edge
+      for (auto&& ePt : ce) out.point(ePt);
+    }
+    out.tag("b");
+    out.write(path);
+  }
 
-  // write beachline items
-  std::ofstream outB(bPath.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
-  for (auto&& e: r.b_edges)
+  void writePolygons(ComputeResult const& r, std::string const& path)
   {
-    outB << "b\n"; // signal for new edge
-    for (auto&& ePt : e)
+    size_t points = 0;
+    for (auto&& poly : r.polygons) points += poly.orderedPointSites.size() + 1;
+    TextFile out(points);
+    for (auto&& poly: r.polygons)
     {
-      outB << ePt.x << " " << ePt.y << std::endl;
+      out.tag("p\n"); // signal for new polygon
+      for (auto&& pt : poly.orderedPointSites) out.point(pt.point);
+      if (!poly.orderedPointSites.empty()) out.point(poly.orderedPointSites[0].point);
     }
+    out.tag("p");
+    out.write(path);
   }
 
-  for (auto&& ce: r.b_curvedEdges)
+  void writeCloseEvents(ComputeResult const& r, std::string const& path)
   {
-    outB << "bc\n"; // signal for new edge
-    for (auto&& ePt : ce)
+    TextFile out(r.b_closeEvents.size() * 2);
+    for (auto&& c: r.b_closeEvents)
     {
-      outB << ePt.x << " " << ePt.y << std::endl;
+      // (x,y, yval)
+      out.number(c.point.x);
+      out.tag(" ");
+      out.number(c.point.y);
+      out.tag(" ");
+      out.number(c.yval);
+      out.tag("\n");
     }
+    out.write(path);
   }
 
-  outB << "b";
-  outB.close();
+  // the files are independent, empty paths are skipped
+  void writeTextResults(ComputeResult const& r, std::string const& pPath,
+    std::string const& ePath, std::string const& bPath, std::string const& cPath)
+  {
+    std::vector<std::function<void()>> files;
+    if (!ePath.empty()) files.push_back([&]() { writeEdges(r, ePath); });
+    if (!bPath.empty()) files.push_back([&]() { writeBeachline(r, bPath); });
+    if (!pPath.empty()) files.push_back([&]() { writePolygons(r, pPath); });
+    if (!cPath.empty()) files.push_back([&]() { writeCloseEvents(r, cPath); });
+    parallelFor(files.size(), [&files](size_t i) { files[i](); });
+  }
+}
+
+void writeResults(ComputeResult const& r, std::string const& ePath)
+{
+  writeTextResults(r, "", ePath, "", "");
+}
+
+void writeResults(ComputeResult const& r, std::string const& ePath, std::string const& bPath)
+{
+  writeTextResults(r, "", ePath, bPath, "");
 }
 
 void writeResults(ComputeResult const& r, std::string const& pPath, std::string const& ePath, std::string const& bPath)
 {
-  writeResults(r, ePath, bPath);
+  writeTextResults(r, pPath, ePath, bPath, "");
+}
+
+void writeResults(ComputeResult const& r, std::string const& pPath,
+  std::string const& ePath, std::string const& bPath, std::string const& cPath)
+{
+  writeTextResults(r, pPath, ePath, bPath, cPath);
+}
 
-  // write polygons
-  std::ofstream outP(
-          pPath.c_str(),
-          std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
-  outP << std::setprecision(std::numeric_limits<decimal_t>::digits10 + 1);
-  for (auto&& poly: r.polygons)
+namespace
+{
+  // results as double, the precision of the input
+  template <typename Items, typename Points>
+  ResultArrays polylineSection(ResultSection_e type, Items const& items, Points points)
   {
-    outP << "p\n"; // signal for new polygon
-    for (auto&& pt : poly.orderedPointSites)
+    ResultArrays s = {type, 2, {0}, {}};
+    s.offsets.reserve(items.size() + 1);
+    for (auto&& item : items)
     {
-      outP << pt.point.x << " " << pt.point.y << std::endl;
+      points(item, [&s](vec2 const& p) {
+        s.values.push_back(static_cast<double>(p.x));
+        s.values.push_back(static_cast<double>(p.y));
+      });
+      s.offsets.push_back(static_cast<uint32_t>(s.values.size() / 2));
     }
-    auto start = poly.orderedPointSites[0];
-    outP << start.point.x << " " << start.point.y << std::endl;
+    return s;
   }
 
-  outP << "p";
-  outP.close();
+  template <typename Items>
+  ResultArrays polylineSection(ResultSection_e type, Items const& items)
+  {
+    return polylineSection(type, items, [](auto const& item, auto add) {
+      for (auto&& p : item) add(p);
+    });
+  }
 }
 
-void writeResults(ComputeResult const& r, std::string const& pPath,
-  std::string const& ePath, std::string const& bPath, std::string const& cPath)
+std::vector<ResultArrays> resultArrays(ComputeResult const& r)
 {
-  writeResults(r, pPath, ePath, bPath);
+  std::vector<ResultArrays> sections;
+  sections.push_back(polylineSection(ResultSection_e::POLYGONS, r.polygons, [](Polygon const& poly, auto add) {
+    for (auto&& e : poly.orderedPointSites) add(e.point);
+  }));
+  sections.push_back(polylineSection(ResultSection_e::EDGES, r.edges, [](std::pair<vec2, vec2> const& e, auto add) {
+    add(e.first);
+    add(e.second);
+  }));
+  sections.push_back(polylineSection(ResultSection_e::CURVED_EDGES, r.curvedEdges));
+  sections.push_back(polylineSection(ResultSection_e::BEACHLINE_EDGES, r.b_edges));
+  sections.push_back(polylineSection(ResultSection_e::BEACHLINE_CURVED_EDGES, r.b_curvedEdges));
+
+  ResultArrays close = {ResultSection_e::CLOSE_EVENTS, 3, {0}, {}};
+  close.offsets.reserve(r.b_closeEvents.size() + 1);
+  close.values.reserve(r.b_closeEvents.size() * 3);
+  for (auto&& c : r.b_closeEvents)
+  {
+    close.values.push_back(static_cast<double>(c.point.x));
+    close.values.push_back(static_cast<double>(c.point.y));
+    close.values.push_back(static_cast<double>(c.yval));
+    close.offsets.push_back(static_cast<uint32_t>(close.offsets.size()));
+  }
+  sections.push_back(std::move(close));
+  return sections;
+}
+
+void writeBinaryResults(ComputeResult const& r, std::string const& path)
+{
+  auto sections = resultArrays(r);
 
-  // write close events
-  std::ofstream outC(
-          cPath.c_str(),
-          std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
-  outC << std::setprecision(std::numeric_limits<decimal_t>::digits10 + 1);
+  ResultHeader header;
+  std::copy(g_resultMagic, g_resultMagic + sizeof(header.magic), header.magic);
+  header.version = RESULT_VERSION;
+  header.sectionCount = static_cast<uint32_t>(sections.size());
 
-  for (auto&& c: r.b_closeEvents)
+  std::vector<ResultSection> table;
+  uint64_t pos = sizeof(ResultHeader) + sections.size() * sizeof(ResultSection);
+  for (auto&& s : sections)
   {
-    // (x,y, yval)
-    outC << c.point.x << " " << c.point.y << " " << c.yval << std::endl;
+    ResultSection t;
+    t.type = s.type;
+    t.stride = s.stride;
+    t.itemCount = s.offsets.size() - 1;
+    t.pointCount = s.offsets.back();
+    t.offsetsPos = pos;
+    pos += s.offsets.size() * sizeof(uint64_t);
+    t.valuesPos = pos;
+    pos += s.values.size() * sizeof(double);
+    table.push_back(t);
   }
 
-  outC.close();
+  std::ofstream ofs(path.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+  ofs.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  ofs.write(reinterpret_cast<char const*>(table.data()), table.size() * sizeof(ResultSection));
+  for (auto&& s : sections)
+  {
+    std::vector<uint64_t> offsets(s.offsets.begin(), s.offsets.end());
+    ofs.write(reinterpret_cast<char const*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    ofs.write(reinterpret_cast<char const*>(s.values.data()), s.values.size() * sizeof(double));
+  }
+  if (!ofs)
+    throw std::runtime_error("Unable to write " + path);
 }
 
-std::shared_ptr<vec2> intersectStraightArcs(std::shared_ptr<Node> l, std::shared_ptr<Node> r, double directrix)
+std::optional<vec2> intersectStraightArcs(Node const& l, Node const& r, double directrix)
 {
-  std::vector<vec2> ints; // 644, 114
-  auto left = math::createV(l->a, l->b, directrix, l->id);
-  auto right = math::createV(r->a, r->b, directrix, r->id);
-  ints = math::vvIntersect(left, right);
+  auto left = math::createV(l, directrix, 0);
+  auto right = math::createV(r, directrix, 0);
+  auto ints = math::vvIntersect(left, right); // 644, 114
   if (ints.empty())
   {
     std::cout << "Empty intersections v-v\n";
-    return nullptr;
+    return std::nullopt;
   }
 
-  if (ints.size() == 1) return std::make_shared<vec2>(ints[0]);
+  if (ints.size() == 1) return ints[0];
   if (ints.size() > 2)
   {
     // get the two ints that are closest to the x value of the left v
     // less than sorts
     std::sort(ints.begin(), ints.end(), [x = right.point.x](vec2 a, vec2 b) {
-        return std::abs(x - a.x) < std::abs(x - b.x);
+        return math::abs(x - a.x) < math::abs(x - b.x);
     });
     ints = {ints[0], ints[1]};
   }
@@ -404,22 +577,22 @@ std::shared_ptr<vec2> intersectStraightArcs(std::shared_ptr<Node> l, std::shared
   auto lower = 1;
   if (prevY < nextY)
     lower = 0;
-  return std::make_shared<vec2>(ints[1-lower]);
+  return ints[1-lower];
 }
 
-std::shared_ptr<vec2> intersectParabolicToStraightArc(std::shared_ptr<Node> l, std::shared_ptr<Node> r, double directrix)
+std::optional<vec2> intersectParabolicToStraightArc(Node const& l, Node const& r, double directrix)
 {
-  std::vector<vec2> ints;
-  if (l->aType == ArcType_e::ARC_PARA)
+  candidates_t ints;
+  if (l.aType == ArcType_e::ARC_PARA)
   {
-    auto left = math::createParabola(l->point, directrix, l->id);
-    auto right = math::createV(r->a, r->b, directrix, r->id);
+    auto left = math::createParabola(l.point, directrix, 0);
+    auto right = math::createV(r, directrix, 0);
     ints = math::vpIntersect(right, left);
     if (ints.empty())
     {
       // use a back-up line since the parabola is probably
       // so narrow that it won't intersect with any ray below p
-      if (math::equiv2(l->point, r->a) || (math::equiv2(l->point, r->b) && left.p < 1e-5))
+      if (math::equiv2(l.point, r.a) || (math::equiv2(l.point, r.b) && left.p < 1e-5))
       {
         auto backupLine = math::createLine(vec2(-1, left.focus.y), vec2(1, left.focus.y));
         ints = math::vbIntersect(right, backupLine);
@@ -427,16 +600,16 @@ std::shared_ptr<vec2> intersectParabolicToStraightArc(std::shared_ptr<Node> l, s
       if (ints.empty())
       {
         std::cout << "0 intersections between p - v\n";
-        return nullptr;
+        return std::nullopt;
       }
     }
-    if (ints.size() == 1) return std::make_shared<vec2>(ints[0]);
+    if (ints.size() == 1) return ints[0];
     if (ints.size() > 2)
     {
-      auto x = l->point.x;
+      auto x = l.point.x;
       // Test get the center intersections
       ints = consolidate(ints, x);
-      if (ints.size() == 1) return std::make_shared<vec2>(ints[0]);
+      if (ints.size() == 1) return ints[0];
     }
 
     std::sort(ints.begin(), ints.end(), math::vec2_x_less_than());
@@ -450,19 +623,19 @@ std::shared_ptr<vec2> intersectParabolicToStraightArc(std::shared_ptr<Node> l, s
     idx = 1 - lower;
 
     // flip the intersection if one is the endpoint of the segment site
-    if (math::equiv2(l->point, r->b)) idx = lower;
-    return std::make_shared<vec2>(ints[idx]);
+    if (math::equiv2(l.point, r.b)) idx = lower;
+    return ints[idx];
   }
 
   // left is a segment and right is a point
-  auto left = math::createV(l->a, l->b, directrix, l->id);
-  auto right = math::createParabola(r->point, directrix, r->id);
+  auto left = math::createV(l, directrix, 0);
+  auto right = math::createParabola(r.point, directrix, 0);
   ints = math::vpIntersect(left, right);
   if (ints.empty())
   {
     // use a back-up line since the parabola is probably
     // so narrow that it won't intersect with any ray below p
-    if (math::equiv2(r->point, l->a) || (math::equiv2(r->point, l->b) && right.p < 1e-5))
+    if (math::equiv2(r.point, l.a) || (math::equiv2(r.point, l.b) && right.p < 1e-5))
     {
       auto backupLine = math::createLine(vec2(-1, right.focus.y), vec2(1, right.focus.y));
       ints = math::vbIntersect(left, backupLine);
@@ -470,16 +643,16 @@ std::shared_ptr<vec2> intersectParabolicToStraightArc(std::shared_ptr<Node> l, s
     if (ints.empty())
     {
       std::cout << "0 intersections between p - v\n";
-      return nullptr;
+      return std::nullopt;
     }
   }
-  if (ints.size() == 1) return std::make_shared<vec2>(ints[0]);
+  if (ints.size() == 1) return ints[0];
   if (ints.size() > 2)
   {
-    auto x = r->point.x;
+    auto x = r.point.x;
     // Test get the center intersections
     ints = consolidate(ints, x);
-    if (ints.size() == 1) return std::make_shared<vec2>(ints[0]);
+    if (ints.size() == 1) return ints[0];
   }
 
   std::sort(ints.begin(), ints.end(), math::vec2_x_less_than());
@@ -493,20 +666,22 @@ std::shared_ptr<vec2> intersectParabolicToStraightArc(std::shared_ptr<Node> l, s
   idx = 1 - lower;
 
   // flip the intersection if one is the endpoint of the segment site
-  if (math::equiv2(r->point, l->b)) idx = lower;
-  return std::make_shared<vec2>(ints[idx]);
+  if (math::equiv2(r.point, l.b)) idx = lower;
+  return ints[idx];
 }
 
-std::shared_ptr<vec2> intersectParabolicArcs(std::shared_ptr<Node> l, std::shared_ptr<Node> r, double directrix)
+std::optional<vec2> intersectParabolicArcs(Node const& l, Node const& r, double directrix)
 {
-  auto left = math::createParabola(l->point, directrix, l->id);
-  auto right = math::createParabola(r->point, directrix, r->id);
+  auto left = math::createParabola(l.point, directrix, 0);
+  auto right = math::createParabola(r.point, directrix, 0);
   auto ints = math::ppIntersect(left.h, left.k, left.p, right.h, right.k, right.p);
 
   if (ints.empty())
   {
     throw std::runtime_error("Invalid intersection p-p");
   }
+  // a degenerate parabola meets the other one once
+  if (ints.size() == 1) return ints[0];
   std::sort(ints.begin(), ints.end(), math::vec2_x_less_than());
 
   auto centX = (ints[0].x + ints[1].x) / 2.0;
@@ -515,22 +690,26 @@ std::shared_ptr<vec2> intersectParabolicArcs(std::shared_ptr<Node> l, std::share
   auto lower = 1;
   if (prevY < nextY)
     lower = 0;
-  return std::make_shared<vec2>(ints[1-lower]);
+  return ints[1-lower];
 }
 
-std::shared_ptr<vec2> intersection(std::shared_ptr<Node> edge, double directrix)
+std::optional<vec2> intersection(node_t edge, NodeArena const& arena, double directrix)
 {
-  auto l = edge->prevArc();
-  auto r = edge->nextArc();
-  return getIntercept(l, r, directrix);
+  auto l = arena.prevArc(edge);
+  auto r = arena.nextArc(edge);
+  return getIntercept(arena[l], arena[r], directrix);
 }
 
-std::shared_ptr<CloseEvent> createCloseEvent(std::shared_ptr<Node> const& arcNode, double directrix)
+std::optional<CloseEvent> createCloseEvent(node_t arc, NodeArena const& arena, double directrix,
+                                           math::BisectorCache& rBisectors)
 {
-  if (!arcNode) return nullptr;
-  auto left = arcNode->prevArc();
-  auto right = arcNode->nextArc();
-  if (!left || !right) return nullptr;
+  if (arc == NULL_NODE) return std::nullopt;
+  auto l = arena.prevArc(arc);
+  auto r = arena.nextArc(arc);
+  if (l == NULL_NODE || r == NULL_NODE) return std::nullopt;
+  auto const& left = arena[l];
+  auto const& arcNode = arena[arc];
+  auto const& right = arena[r];
 
   vec2 closePoint(0.0, 0.0);
   auto el = math::createEventFromNode(left);
@@ -539,29 +718,27 @@ std::shared_ptr<CloseEvent> createCloseEvent(std::shared_ptr<Node> const& arcNod
 
   // NOTE labels from generated events will not match for connected sites
 
-  if (arcNode->aType == ArcType_e::ARC_PARA
-      && left->aType == ArcType_e::ARC_PARA
-      && left->aType == ArcType_e::ARC_PARA)
+  if (arcNode.aType == ArcType_e::ARC_PARA
+      && left.aType == ArcType_e::ARC_PARA
+      && left.aType == ArcType_e::ARC_PARA)
   {
     // All three are points
-    auto equi = math::equidistant(el, ec, er);
-    if (equi.empty())  return nullptr;
+    auto equi = math::equidistant(el, ec, er, rBisectors);
+    if (equi.empty())  return std::nullopt;
     closePoint = equi.front();
-    auto u = math::subtract(left->point, arcNode->point);
-    auto v = math::subtract(left->point, right->point);
     // Check if there should be a close event added. In some
     // cases there shouldn't be like when the three sites are colinear
-    if (math::crossProduct(u, v) < 0)
+    if (math::orient2d(left.point, arcNode.point, right.point) < 0)
     {
-      auto r = math::length(math::subtract(arcNode->point, closePoint));
+      auto r = math::length(math::subtract(arcNode.point, closePoint));
       auto event_y = closePoint.y - r;
-      return std::make_shared<CloseEvent>(newCloseEvent(event_y, arcNode, closePoint));
+      return newCloseEvent(event_y, arc, arcNode.generation, closePoint);
     }
-    return nullptr;
+    return std::nullopt;
   }
 
   // can compute up to 6 equi points
-  auto points = math::equidistant(el, ec, er);
+  auto points = math::equidistant(el, ec, er, rBisectors);
 
   for (auto&& e : {el, ec, er})
   {
@@ -569,34 +746,35 @@ std::shared_ptr<CloseEvent> createCloseEvent(std::shared_ptr<Node> const& arcNod
       points = math::filterVisiblePoints(e, points);
   }
 
-  if (points.empty()) return nullptr;
+  if (points.empty()) return std::nullopt;
 
   // filter by site association
   points = math::filterBySiteAssociation(el, ec, er, points);
 
-  if (points.empty()) return nullptr;
+  if (points.empty()) return std::nullopt;
   if (points.size() == 1)
   {
     closePoint = points[0];
     auto diff = getDiff(left, arcNode, right, closePoint, directrix);
-    if (!validDiff(diff)) return nullptr;
+    if (!validDiff(diff)) return std::nullopt;
   } else {
     auto p = chooseClosePoint(left, arcNode, right, points, directrix);
-    if (!p) return nullptr;
+    if (!p) return std::nullopt;
     closePoint = *p;
   }
 
   auto radius = getRadius(closePoint, left, arcNode, right);
 
-  return std::make_shared<CloseEvent>(newCloseEvent(closePoint.y - radius, arcNode, closePoint));
+  return newCloseEvent(closePoint.y - radius, arc, arcNode.generation, closePoint);
 }
 
-std::vector<CloseEvent> processCloseEvents(std::vector<std::shared_ptr<Node>> closingNodes, double directrix)
+newCloseEvents_t processCloseEvents(closingNodes_t const& closingNodes, NodeArena const& arena,
+                                    double directrix, math::BisectorCache& rBisectors)
 {
-  std::vector<CloseEvent> ret;
+  newCloseEvents_t ret;
   for (auto&& n : closingNodes)
   {
-    auto e = createCloseEvent(n, directrix);
+    auto e = createCloseEvent(n, arena, directrix, rBisectors);
     if (e)
       ret.push_back(*e);
   }
@@ -604,182 +782,304 @@ std::vector<CloseEvent> processCloseEvents(std::vector<std::shared_ptr<Node>> cl
   return ret;
 }
 
-std::vector<CloseEvent> add(EventPacket const& packet, std::vector<CloseEvent>& rCQueue)
+newCloseEvents_t add(EventPacket const& packet, node_t& root, NodeArena& rArena, CloseEventQueue& rCQueue,
+                     math::BisectorCache& rBisectors)
 {
-  auto arcNode = math::createArcNode(packet.site);
+  auto arcNode = math::createArcNode(packet.site, rArena);
   auto directrix = packet.site.point.y;
 
-  if (root == nullptr)
+  if (root == NULL_NODE)
   {
-    auto subTreeData = generateSubTree(packet, arcNode, rCQueue, nullptr);
-    root = subTreeData.root;
+    auto subTreeData = generateSubTree(packet, arcNode, rArena, rCQueue);
+    root = balanceSubTree(subTreeData.root, rArena);
     return {};
   }
 
   auto parent = root;
   // var side, child;
-  std::shared_ptr<Node> child;
+  node_t child;
 
-  if (root->aType != ArcType_e::EDGE)
+  if (rArena[root].aType != ArcType_e::EDGE)
   {
     child = root;
-    auto subTreeData = generateSubTree(packet, arcNode, rCQueue, child);
-    root = subTreeData.root;
-    return processCloseEvents(subTreeData.nodesToClose, directrix);
+    auto subTreeData = generateSubTree(packet, arcNode, rArena, rCQueue, child);
+    root = balanceSubTree(subTreeData.root, rArena);
+    return processCloseEvents(subTreeData.nodesToClose, rArena, directrix, rBisectors);
   }
 
-  // Do a binary search to find the arc node that the new
-  // site intersects with
-  auto rslt = intersection(parent, directrix);
-  if (!rslt) throw std::runtime_error("Invalid intersection on add()");
-  auto side = (packet.site.point.x < rslt->x) ? Side_e::LEFT : Side_e::RIGHT;
-  child = math::getChild(parent, side);
-  while (child->aType == ArcType_e::EDGE)
+  // Binary search the breakpoints in beachline order for the arc
+  // that the new site intersects with. Near segment sites the
+  // breakpoints are not always sorted and several arcs can bracket the
+  // site. Searching by arc index instead of down the tree picks the
+  // same one of them whatever the shape of the tree. Each probe looks
+  // its arc up from the root so the search is O(log^2 n).
+  uint32_t lo = 0;
+  uint32_t hi = rArena[root].arcs - 1;
+  while (lo < hi)
   {
-    parent = child;
-    auto i = intersection(parent, directrix);
-    if (!i)
-      throw std::runtime_error("Invalid intersection on 'Add'");
+    auto mid = lo + (hi - lo) / 2;
+    auto left = arcAt(root, mid, rArena);
+    auto right = left;
+    auto probe = mid;
+    auto i = intersection(rArena.nextEdge(left), rArena, directrix);
+    // compare against the closest breakpoint in range that intersects,
+    // looking at most 4 arcs away
+    for (uint32_t d = 1; !i && d <= 4 && (mid >= lo + d || mid + d < hi); ++d)
+    {
+      if (mid >= lo + d)
+      {
+        left = rArena.prevArc(left);
+        i = intersection(rArena.nextEdge(left), rArena, directrix);
+        probe = mid - d;
+      }
+      if (!i && mid + d < hi)
+      {
+        right = rArena.nextArc(right);
+        i = intersection(rArena.nextEdge(right), rArena, directrix);
+        probe = mid + d;
+      }
+    }
+    // none does, the leftmost arc in range is taken
+    if (!i) break;
 
-    side = (packet.site.point.x < i->x) ? Side_e::LEFT : Side_e::RIGHT;
-    child = math::getChild(parent, side);
+    if (packet.site.point.x < i->x)
+      hi = probe;
+    else
+      lo = probe + 1;
   }
+  child = arcAt(root, lo, rArena);
+  parent = rArena[child].parent;
+  auto side = rArena[parent].left == child ? Side_e::LEFT : Side_e::RIGHT;
 
-  auto subTreeData = generateSubTree(packet, arcNode, rCQueue, child);
-  math::setChild(parent, subTreeData.root, side);
+  auto subTreeData = generateSubTree(packet, arcNode, rArena, rCQueue, child);
+  math::setChild(parent, balanceSubTree(subTreeData.root, rArena), side, rArena);
+  rebalance(parent, root, rArena);
 
-  return processCloseEvents(subTreeData.nodesToClose, directrix);
+  return processCloseEvents(subTreeData.nodesToClose, rArena, directrix, rBisectors);
 }
 
-std::vector<CloseEvent> remove(std::shared_ptr<Node> const& arcNode, vec2 point,
-            double directrix, std::vector<CloseEvent>& rCQueue)
+newCloseEvents_t remove(node_t arcNode, vec2 point,
+            double directrix, node_t& rRoot, NodeArena& rArena, CloseEventQueue& rCQueue,
+            math::BisectorCache& rBisectors,
+            std::vector<std::pair<vec2, vec2>>& rEdges,
+            std::vector<std::vector<vec2>>& rCurvedEdges)
 {
   // resolve ending edges
-  auto prevEdge = arcNode->prevEdge();
-  auto nextEdge = arcNode->nextEdge();
+  auto prevEdge = rArena.prevEdge(arcNode);
+  auto nextEdge = rArena.nextEdge(arcNode);
 
   // the left and right edge converge onto the point
-  if (prevEdge && !prevEdge->overridden)
-    commitEdge(prevEdge, point);
-  if (nextEdge && !nextEdge->overridden)
-    commitEdge(nextEdge, point);
+  if (prevEdge != NULL_NODE && !rArena[prevEdge].overridden)
+    commitEdge(prevEdge, point, rArena, rBisectors, rEdges, rCurvedEdges);
+  if (nextEdge != NULL_NODE && !rArena[nextEdge].overridden)
+    commitEdge(nextEdge, point, rArena, rBisectors, rEdges, rCurvedEdges);
 
-  auto parent = arcNode->pParent;
-  auto grandparent = parent->pParent;
-  auto side = (parent->pLeft && parent->pLeft->id == arcNode->id) ? Side_e::LEFT : Side_e::RIGHT;
-  auto parentSide = (grandparent->pLeft->id == parent->id) ? Side_e::LEFT : Side_e::RIGHT;
+  auto prevArc = rArena.prevArc(arcNode);
+  auto nextArc = rArena.nextArc(arcNode);
+
+  // the parent is one of the two converging edges, the other one
+  // is an ancestor that survives as the edge between prevArc and nextArc
+  auto parent = rArena[arcNode].parent;
+  auto survivor = parent == prevEdge ? nextEdge : prevEdge;
+  auto grandparent = rArena[parent].parent;
+  auto side = rArena[parent].left == arcNode ? Side_e::LEFT : Side_e::RIGHT;
 
   auto siblingSide = side == Side_e::LEFT ? Side_e::RIGHT : Side_e::LEFT;
-  auto sibling = math::getChild(parent, siblingSide);
-  math::setChild(grandparent, sibling, parentSide);
-  // the grand parent inherits the children and a new start
-  grandparent->edgeStart = point;
-  sibling->pParent = grandparent;
+  auto sibling = math::getChild(parent, siblingSide, rArena);
+  if (grandparent != NULL_NODE)
+  {
+    auto parentSide = rArena[grandparent].left == parent ? Side_e::LEFT : Side_e::RIGHT;
+    math::setChild(grandparent, sibling, parentSide, rArena);
+  }
+  else
+  {
+    rRoot = sibling;
+    rArena[sibling].parent = NULL_NODE;
+    rArena[sibling].side = Side_e::UNDEFINED;
+  }
+  // the surviving edge starts a new breakpoint between prevArc and nextArc
+  if (survivor != NULL_NODE)
+    rArena[survivor].edgeStart = point;
+  if (parent == prevEdge)
+    rArena.link(prevArc, nextEdge);
+  else
+    rArena.link(prevEdge, nextArc);
 
   // Cancel the close event for this arc and adjoining arcs.
   // Add new close events for new sibling arcs.
-  removeCloseEventFromQueue(arcNode->id, rCQueue);
-  std::vector<CloseEvent> closeEvents;
-  auto prevArc = grandparent->prevArc();
-  removeCloseEventFromQueue(prevArc->id, rCQueue);
+  rCQueue.cancel(arcNode, rArena);
+  // the arc and its edge are out of the tree, their slots can be reused
+  rArena.release(arcNode);
+  rArena.release(parent);
+  rebalance(grandparent, rRoot, rArena);
+
+  newCloseEvents_t closeEvents;
+  rCQueue.cancel(prevArc, rArena);
 
-  auto e = createCloseEvent(prevArc, directrix);
+  auto e = createCloseEvent(prevArc, rArena, directrix, rBisectors);
   if (e)
     closeEvents.push_back(*e);
 
-  auto nextArc = grandparent->nextArc();
-  removeCloseEventFromQueue(nextArc->id, rCQueue);
-  e = createCloseEvent(nextArc, directrix);
+  rCQueue.cancel(nextArc, rArena);
+  e = createCloseEvent(nextArc, rArena, directrix, rBisectors);
   if (e)
     closeEvents.push_back(*e);
   return closeEvents;
 }
 
-ComputeResult fortune(std::vector<Event> queue, double const& sweepline, std::string& rMsg, std::string& rErr)
+/////////////////////////////////// SweepState /////////////////////////////////////
+
+SweepState::SweepState(std::vector<Event> queue, CancelMode_e cancelMode, size_t checkpointInterval)
+  : m_queue(std::move(queue)),
+  m_remaining(m_queue.size()),
+  m_arena(),
+  m_closeEvents(cancelMode),
+  m_root(NULL_NODE),
+  m_bisectors(),
+  m_edges(),
+  m_curvedEdges(),
+  m_curY(std::numeric_limits<double>::max()),
+  m_eventCount(0),
+  m_failed(false),
+  m_cancelled(false),
+  m_checkpointInterval(checkpointInterval),
+  m_checkpoints()
 {
-  root = nullptr;
-  g_edges = {};
-  g_curvedEdges = {};
-
-  decimal_t curY = 1000.0;
-
-  // set perhaps?
-  std::vector<CloseEvent> closeEvents;
-
-  Event event(EventType_e::UNDEFINED, 0);
-  CloseEvent cEvent;
-  bool onClose = false;
-
-  // testing only
-  int count = 0;
+  saveCheckpoint();
+}
 
+ComputeResult SweepState::advance(double const& sweepline, std::string& rMsg, std::string& rErr,
+                                  SweepControl const* pControl)
+{
+  m_cancelled = false;
   try
   {
-    while (!queue.empty() || !closeEvents.empty())
+    // moving up (or recovering from a failed sweep) restarts from the
+    // closest checkpoint that has not passed the sweepline
+    if (m_failed || sweepline > m_curY)
+      restore(sweepline);
+
+    while (step(sweepline))
     {
-      count++;
-      // std::cout << "Count:" << count << std::endl;
-      // get the next event closest to the sweepline
-      if (queue.empty() || (!closeEvents.empty() && closeEvents.back().yval >= math::getEventY(queue.back())))
-      {
-        onClose = true;
-        cEvent = closeEvents.back();
-        closeEvents.pop_back();
-        curY = cEvent.yval;
-      }
-      else
-      {
-        onClose = false;
-        event = queue.back();
-        queue.pop_back();
-        curY = math::getEventY(event);
-      }
-      if (curY < sweepline)
-        break;
+      if (m_checkpointInterval > 0
+          && m_eventCount >= m_checkpoints.back().eventCount + std::max(m_checkpointInterval, m_arena.slots()))
+        saveCheckpoint();
 
-      if (onClose)
+      if (pControl && pControl->interval > 0 && m_eventCount % pControl->interval == 0)
       {
-        // DEBUG ONLY
-        // if (!cEvent.arcNode) throw std::runtime_error("Close Event invalid");
-
-        auto newEvents = remove(cEvent.arcNode, cEvent.point, curY, closeEvents);
-        for (auto&& e : newEvents)
+        if (pControl->progress) pControl->progress(m_eventCount, static_cast<double>(m_curY));
+        // every event so far is committed, the next advance goes on from here
+        if (pControl->cancelled)
         {
-          // if (e.yval < curY)
-          if (e.yval < curY - 0.000001 || std::abs(e.yval - curY) < 1e-6) // Simplify?
-            sortedInsert(e, closeEvents);
-        }
-      }
-      else
-      {
-        // Add Event
-        auto packet = getEventPacket(event, queue);
-        auto newEvents = add(packet, closeEvents);
-        for (auto&& e : newEvents)
-        {
-          // if (e.yval < curY)
-          if (e.yval < curY - 0.000001 || std::abs(e.yval - curY) < 1e-6) // Simplify?
-            sortedInsert(e, closeEvents);
+          m_cancelled = true;
+          rMsg += ": Cancelled at Count:" + std::to_string(m_eventCount);
+          return ComputeResult();
         }
       }
     }
 
-    rMsg += ": Count:" + count;
-    ComputeResult rslt{{}, g_edges, g_curvedEdges, {}, {}, closeEvents};
+    rMsg += ": Count:" + std::to_string(m_eventCount);
+    ComputeResult rslt{{}, m_edges, m_curvedEdges, {}, {}, m_closeEvents.toVector(m_arena)};
 
-    if (!root)
+    if (m_root == NULL_NODE)
       rMsg += ": Root node null";
 
     // DEBUG ONLY
-    setBeachline(root, rslt, sweepline);
+    setBeachline(m_root, m_arena, rslt, sweepline);
     rMsg += ": V Count:" + std::to_string(rslt.b_edges.size())
     + ": Para Count:" + std::to_string(rslt.b_curvedEdges.size());
+
+    size_t maxDepth;
+    double avgDepth;
+    beachlineDepth(maxDepth, avgDepth);
+    rMsg += ": Max Depth:" + std::to_string(maxDepth) + ": Avg Depth:" + std::to_string(avgDepth);
     return rslt;
   }
   catch(std::exception const& e)
   {
+    m_failed = true;
     rErr += "Error: " + std::string(e.what());
   }
 
   return ComputeResult();
 }
+
+bool SweepState::step(double const& sweepline)
+{
+  // lazily cancelled events are dropped here
+  while (!m_closeEvents.empty() && CloseEventQueue::isStale(m_closeEvents.top(), m_arena))
+    m_closeEvents.pop();
+
+  if (m_remaining == 0 && m_closeEvents.empty())
+    return false;
+
+  // get the next event closest to the sweepline
+  auto onClose = m_remaining == 0
+    || (!m_closeEvents.empty() && m_closeEvents.top().yval >= math::getEventY(m_queue[m_remaining - 1]));
+  auto nextY = onClose ? m_closeEvents.top().yval : math::getEventY(m_queue[m_remaining - 1]);
+  if (nextY < sweepline)
+    return false;
+
+  m_curY = nextY;
+  ++m_eventCount;
+  m_bisectors.trim();
+  newCloseEvents_t newEvents;
+  if (onClose)
+  {
+    auto cEvent = m_closeEvents.pop();
+    newEvents = remove(cEvent.arcNode, cEvent.point, m_curY, m_root, m_arena, m_closeEvents, m_bisectors,
+                       m_edges, m_curvedEdges);
+  }
+  else
+  {
+    // Add Event
+    auto const& event = m_queue[--m_remaining];
+    auto packet = getEventPacket(event, m_queue, m_remaining);
+    newEvents = add(packet, m_root, m_arena, m_closeEvents, m_bisectors);
+  }
+
+  for (auto&& e : newEvents)
+  {
+    // if (e.yval < curY)
+    if (e.yval < m_curY - 0.000001 || math::abs(e.yval - m_curY) < 1e-6) // Simplify?
+      m_closeEvents.push(e);
+  }
+  return true;
+}
+
+void SweepState::saveCheckpoint()
+{
+  // handles stay valid in a copy of the arena so the queue is copied as is
+  m_checkpoints.push_back({m_eventCount, m_curY, m_remaining, m_root, m_arena,
+                           m_closeEvents, m_edges.size(), m_curvedEdges.size()});
+}
+
+void SweepState::restore(double const& sweepline)
+{
+  // the last checkpoint taken at or above the sweepline
+  auto itr = std::find_if(m_checkpoints.rbegin(), m_checkpoints.rend(),
+    [sweepline](Checkpoint const& c) { return c.curY >= sweepline; });
+  if (itr == m_checkpoints.rend())
+    itr = m_checkpoints.rend() - 1;
+
+  m_eventCount = itr->eventCount;
+  m_curY = itr->curY;
+  m_remaining = itr->remaining;
+  m_root = itr->root;
+  m_arena = itr->arena;
+  m_closeEvents = itr->closeEvents;
+  // committed edges are append only
+  m_edges.resize(itr->edgeCount, {vec2(0.0, 0.0), vec2(0.0, 0.0)});
+  m_curvedEdges.resize(itr->curvedEdgeCount);
+  m_failed = false;
+}
+
+ComputeResult fortune(std::vector<Event> queue, double const& sweepline, std::string& rMsg, std::string& rErr,
+                      CancelMode_e cancelMode)
+{
+  // single sweep - no checkpoints needed
+  SweepState state(std::move(queue), cancelMode, 0);
+  return state.advance(sweepline, rMsg, rErr);
+}
+
+} // namespace GVD_SCALAR_NS
@@ -1,11 +1,18 @@
 #ifndef FORTUNE_HH
 #define FORTUNE_HH
 
+#include "closeEventQueue.hh"
+#include "math.hh"
+#include "resultFile.hh"
+#include "sweepControl.hh"
 #include "types.hh"
 
-#include <memory>
+#include <optional>
 #include <string>
 
+namespace GVD_SCALAR_NS
+{
+
 struct ComputeResult
 {
   std::vector<Polygon> polygons;
@@ -22,13 +29,87 @@ void writeResults(ComputeResult const& r, std::string const& ePath, std::string
 void writeResults(ComputeResult const& r, std::string const& pPath, std::string const& ePath, std::string const& bPath);
 void writeResults(ComputeResult const& r, std::string const& pPath,
   std::string const& ePath, std::string const& bPath, std::string const& cPath);
+// all results in one binary file, see resultFile.hh
+void writeBinaryResults(ComputeResult const& r, std::string const& path);
+// the sections of writeBinaryResults in its order, points as double
+std::vector<ResultArrays> resultArrays(ComputeResult const& r);
+
+std::optional<vec2> intersectStraightArcs(Node const& l, Node const& r, double directrix);
+std::optional<vec2> intersectParabolicToStraightArc(Node const& l, Node const& r, double directrix);
+std::optional<vec2> intersectParabolicArcs(Node const& l, Node const& r, double directrix);
+
+std::optional<vec2> intersection(node_t edge, NodeArena const& arena, double directrix);
+
+void beachlineDepth(node_t root, NodeArena const& arena, size_t& rMaxDepth, double& rAvgDepth);
+
+//------------------------------------------------------------
+// SweepState
+// Persistent sweep engine. Owns the beachline node arena, the site
+// and close event queues, the bisector cache and the committed edges. advance()
+// continues the sweep from the current y down to a lower
+// sweepline. Moving the sweepline back up restores the closest
+// checkpoint above it instead of recomputing from the top.
+// A checkpoint copies the arena, so one is taken once at least
+// checkpointInterval events and as many events as the arena has
+// slots went by. Their memory stays linear in the events,
+// 0 keeps only the initial state.
+//------------------------------------------------------------
+class SweepState
+{
+public:
+  SweepState(std::vector<Event> queue, CancelMode_e cancelMode = CancelMode_e::EAGER,
+             size_t checkpointInterval = 256);
+
+  // with a control the advance may stop early, see cancelled()
+  ComputeResult advance(double const& sweepline, std::string& rMsg, std::string& rErr,
+                        SweepControl const* pControl = nullptr);
+
+  // the last advance was stopped by its control before the sweepline
+  bool cancelled() const { return m_cancelled; }
+  decimal_t currentY() const { return m_curY; }
+  size_t eventCount() const { return m_eventCount; }
+  void beachlineDepth(size_t& rMaxDepth, double& rAvgDepth) const
+  {
+    GVD_SCALAR_NS::beachlineDepth(m_root, m_arena, rMaxDepth, rAvgDepth);
+  }
 
-std::shared_ptr<vec2> intersectStraightArcs(std::shared_ptr<Node> l, std::shared_ptr<Node> r, double directrix);
-std::shared_ptr<vec2> intersectParabolicToStraightArc(std::shared_ptr<Node> l, std::shared_ptr<Node> r, double directrix);
-std::shared_ptr<vec2> intersectParabolicArcs(std::shared_ptr<Node> l, std::shared_ptr<Node> r, double directrix);
+private:
+  struct Checkpoint
+  {
+    size_t eventCount;
+    decimal_t curY;
+    size_t remaining;
+    node_t root;
+    NodeArena arena;
+    CloseEventQueue closeEvents;
+    size_t edgeCount;
+    size_t curvedEdgeCount;
+  };
+
+  // process the next event if it is at or above the sweepline
+  bool step(double const& sweepline);
+  void saveCheckpoint();
+  void restore(double const& sweepline);
+
+  std::vector<Event> m_queue; // site events, never modified
+  size_t m_remaining; // unprocessed site events at the front of m_queue
+  NodeArena m_arena; // beachline nodes
+  CloseEventQueue m_closeEvents;
+  node_t m_root;
+  math::BisectorCache m_bisectors; // not checkpointed, keyed by site ids
+  std::vector<std::pair<vec2, vec2>> m_edges;
+  std::vector<std::vector<vec2>> m_curvedEdges;
+  decimal_t m_curY; // y of the last processed event
+  size_t m_eventCount;
+  bool m_failed;
+  bool m_cancelled;
+  size_t m_checkpointInterval;
+  std::vector<Checkpoint> m_checkpoints;
+};
 
-std::shared_ptr<vec2> intersection(std::shared_ptr<Node> edge, double directrix);
+ComputeResult fortune(std::vector<Event> queue, double const& sweepline, std::string& rMsg, std::string& rErr,
+                      CancelMode_e cancelMode = CancelMode_e::EAGER);
 
-ComputeResult fortune(std::vector<Event> queue, double const& sweepline, std::string& rMsg, std::string& rErr);
+} // namespace GVD_SCALAR_NS
 
 #endif
@@ -3,11 +3,8 @@
 #include <fstream>
 #include <chrono>
 
-#include "fortune.hh"
-#include "dataset.hh"
-#include "math.hh"
-#include "types.hh"
-#include "utils.hh"
+#include "parallel.hh"
+#include "sweepEngine.hh"
 
 int main(int argc, char** argv)
 {
@@ -15,27 +12,86 @@ int main(int argc, char** argv)
   // all paths must be relative to the gvd-fortune/ folder
   if (argc < 2)
   {
-    std::cout << "Usage: <program> <input file containing a list of file paths>\n";
+    std::cout << "Usage: <program> <input file containing a list of file paths, a scene file or a .map grid> [--lazy-cancel]"
+              << " [--scalar=double|long-double|float128] [--threads=<ingest threads>]"
+              << " [--check-crossings|--repair-crossings]"
+              << " [--text-output=<directory>] [--binary-output=<file>]\n";
     return 0;
   }
 
   std::string i(argv[1]);
+  // close event cancellation mode - eager unless requested
+  auto cancelMode = CancelMode_e::EAGER;
+  std::string scalar("long-double");
+  bool checkCrossings = false;
+  bool repairCrossings = false;
+  std::string textOutput;
+  std::string binaryOutput;
+  for (int a = 2; a < argc; ++a)
+  {
+    std::string arg(argv[a]);
+    if (arg == "--lazy-cancel")
+      cancelMode = CancelMode_e::LAZY;
+    else if (arg.compare(0, 9, "--scalar=") == 0)
+      scalar = arg.substr(9);
+    else if (arg.compare(0, 10, "--threads=") == 0)
+      setThreadCount(std::stoul(arg.substr(10)));
+    else if (arg == "--check-crossings")
+      checkCrossings = true;
+    else if (arg == "--repair-crossings")
+      checkCrossings = repairCrossings = true;
+    else if (arg.compare(0, 14, "--text-output=") == 0)
+      textOutput = arg.substr(14);
+    else if (arg.compare(0, 16, "--binary-output=") == 0)
+      binaryOutput = arg.substr(16);
+  }
   // Read in the dataset files
   try
   {
     // only wrap for testing
-    auto polygons = processInputFiles(i);
+    auto engine = createSweepEngine(scalarFromString(scalar));
+    // single sweep - no checkpoints needed
+    auto loadStart = std::chrono::system_clock::now();
+    auto vertexCount = engine->load(i, cancelMode, 0);
+    std::chrono::duration<double> loadSeconds = std::chrono::system_clock::now() - loadStart;
+    std::cout << "Ingest Duration: " << loadSeconds.count() << "s (" << vertexCount << " vertices, "
+              << vertexCount / loadSeconds.count() << " vertices/s)\n";
+    if (checkCrossings)
+    {
+      auto checkStart = std::chrono::system_clock::now();
+      auto crossings = engine->findCrossings(repairCrossings);
+      std::chrono::duration<double> checkSeconds = std::chrono::system_clock::now() - checkStart;
+      std::cout << "Crossing Check Duration: " << checkSeconds.count() << "s (" << crossings.size() << " crossings)\n";
+      for (auto&& c : crossings)
+      {
+        std::cout << "Crossing polygons: " << c.first << " " << c.second
+                  << (repairCrossings ? " - dropped " + std::to_string(c.second) : std::string()) << "\n";
+      }
+    }
     auto start = std::chrono::system_clock::now();
-    auto queue = createDataQueue(polygons);
     std::string msg;
     std::string err;
-    fortune(queue, -0.8858, msg, err);
+    engine->advance(-0.8858, msg, err);
     std::cout << "Msg: " << msg << std::endl;
     std::cout << "Error: " << err << std::endl;
     auto end = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsedSeconds = end-start;
     std::cout << "Process Duration: " << elapsedSeconds.count() << "s\n";
 
+    if (!textOutput.empty() || !binaryOutput.empty())
+    {
+      auto writeStart = std::chrono::system_clock::now();
+      if (!textOutput.empty())
+      {
+        engine->writeResults(textOutput + "/output_polygons.txt", textOutput + "/output_edges.txt",
+                             textOutput + "/output_beachline.txt", textOutput + "/output_close.txt");
+      }
+      if (!binaryOutput.empty())
+        engine->writeBinaryResults(binaryOutput);
+      std::chrono::duration<double> writeSeconds = std::chrono::system_clock::now() - writeStart;
+      std::cout << "Write Duration: " << writeSeconds.count() << "s\n";
+    }
+
     // testing only
     // std::cout << "printing test files\n";
     // std::vector<std::string> files;
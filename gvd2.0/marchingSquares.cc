@@ -0,0 +1,106 @@
+#include "marchingSquares.hh"
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+  // edge directions in clockwise order on screen (y down),
+  // (d + 1) % 4 turns right and (d + 3) % 4 turns left
+  enum Dir_e : uint8_t
+  {
+    RIGHT = 0,
+    DOWN = 1,
+    LEFT = 2,
+    UP = 3
+  };
+
+  const int g_dx[4] = {1, 0, -1, 0};
+  const int g_dy[4] = {0, 1, 0, -1};
+
+  // corner where blocked cells meet diagonally
+  const uint8_t SHARED = 0x10;
+  const uint8_t EDGES = 0x0f;
+  // cells a shared corner moves towards the loop's cell
+  const double g_sharedInset = 0.05;
+
+  inline uint8_t bit(unsigned d) { return static_cast<uint8_t>(1u << d); }
+}
+
+std::vector<std::vector<GridPoint>> traceContours(std::vector<uint8_t> const& blocked, size_t width, size_t height)
+{
+  if (blocked.size() != width * height)
+    throw std::runtime_error("Grid size does not match " + std::to_string(width) + "x" + std::to_string(height));
+
+  // one row major pass marks the outgoing boundary edges of each corner
+  auto stride = width + 1;
+  std::vector<uint8_t> edges(stride * (height + 1), 0);
+  for (size_t r = 0; r < height; ++r)
+  {
+    auto const* row = blocked.data() + r * width;
+    auto const* above = r > 0 ? row - width : nullptr;
+    auto const* below = r + 1 < height ? row + width : nullptr;
+    for (size_t c = 0; c < width; ++c)
+    {
+      if (!row[c]) continue;
+      if (!above || !above[c]) edges[r * stride + c + 1] |= bit(LEFT);
+      if (!below || !below[c]) edges[(r + 1) * stride + c] |= bit(RIGHT);
+      if (c == 0 || !row[c - 1]) edges[r * stride + c] |= bit(DOWN);
+      if (c + 1 == width || !row[c + 1]) edges[(r + 1) * stride + c + 1] |= bit(UP);
+    }
+  }
+  // only a diagonal corner has two outgoing edges
+  for (auto&& e : edges)
+  {
+    unsigned count = 0;
+    for (unsigned d = 0; d < 4; ++d) count += (e & bit(d)) != 0;
+    if (count == 2) e |= SHARED;
+  }
+
+  std::vector<std::vector<GridPoint>> rslt;
+  for (size_t start = 0; start < edges.size(); ++start)
+  {
+    // a shared corner starts two loops
+    while (edges[start] & EDGES)
+    {
+      unsigned startDir = 0;
+      while (!(edges[start] & bit(startDir))) ++startDir;
+      edges[start] &= static_cast<uint8_t>(~bit(startDir));
+
+      // the first corner in row major order is a turn, it is
+      // added once the loop comes back to it
+      std::vector<GridPoint> loop;
+      auto v = start;
+      unsigned d = startDir;
+      for (;;)
+      {
+        v = static_cast<size_t>(static_cast<long long>(v) + g_dx[d] + g_dy[d] * static_cast<long long>(stride));
+
+        // turning left keeps diagonal neighbours apart
+        auto open = (edges[v] & EDGES) | (v == start ? bit(startDir) : 0);
+        unsigned next;
+        if (open & bit((d + 3) % 4)) next = (d + 3) % 4;
+        else if (open & bit(d)) next = d;
+        else if (open & bit((d + 1) % 4)) next = (d + 1) % 4;
+        else throw std::runtime_error("Open contour in grid");
+
+        if (next != d)
+        {
+          GridPoint p = {static_cast<double>(v % stride), static_cast<double>(v / stride)};
+          if (edges[v] & SHARED)
+          {
+            // the loop's cell is behind and after the turn
+            p.x += (g_dx[next] - g_dx[d]) * g_sharedInset;
+            p.y += (g_dy[next] - g_dy[d]) * g_sharedInset;
+          }
+          loop.push_back(p);
+        }
+        if (v == start && next == startDir) break;
+        edges[v] &= static_cast<uint8_t>(~bit(next));
+        d = next;
+      }
+      rslt.push_back(std::move(loop));
+    }
+  }
+  return rslt;
+}
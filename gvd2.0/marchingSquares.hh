@@ -0,0 +1,29 @@
+#ifndef MARCHING_SQUARES_HH
+#define MARCHING_SQUARES_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// contour corner, x right and y down in cells
+struct GridPoint
+{
+  double x;
+  double y;
+};
+
+//------------------------------------------------------------
+// traceContours
+// Boundary loops of the blocked cells of a width x height grid
+// given row major, cells outside the grid count as free. Every
+// blocked region gives its outer loop plus one loop per hole,
+// blocked cells are on the left walking a loop (y down). Cells
+// touching only at a corner stay apart, as in the 4 connected
+// labelling of the browser code, and each loop through such a
+// corner is pulled a little towards its own cell so no two loops
+// share a point. A loop lists its corners once, straight runs of
+// cell edges are merged.
+//------------------------------------------------------------
+std::vector<std::vector<GridPoint>> traceContours(std::vector<uint8_t> const& blocked, size_t width, size_t height);
+
+#endif
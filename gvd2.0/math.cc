@@ -1,6 +1,7 @@
 #include "math.hh"
 
-#include <map>
+namespace GVD_SCALAR_NS
+{
 
 namespace
 {
@@ -13,10 +14,10 @@ namespace
     return (r1 && !r2) || (!r1 && r2);
   }
 
-  std::vector<vec2> getLineIntersections(V const& l, V const& r)
+  candidates_t getLineIntersections(V const& l, V const& r)
   {
-    std::vector<math::Bisector> left;
-    std::vector<math::Bisector> right;
+    math::bisectors_t left;
+    math::bisectors_t right;
     // 3 cases: 1 l divides r, r divides l, neither divide
     auto t1 = intersectsTarget(l, r);
     auto t2 = intersectsTarget(r, l);
@@ -88,27 +89,25 @@ namespace
     }
   };
 
-  std::vector<vec4> rotateZ(decimal_t theta)
+  std::array<vec4, 4> rotateZ(decimal_t theta)
   {
     auto radians = theta * (std::atan(1)*4) / 180.0;
     // double c = 0.0;
-    // if ( std::abs(theta) == 90)
+    // if ( math::abs(theta) == 90)
     //   c = 0.0;
     // else
-    //   c = std::cos(radians);
-    auto c = std::cos(radians);
-    auto s = std::sin(radians);
-    return {vec4( c,   -s, 0.0, 0.0),
-            vec4( s,    c, 0.0, 0.0),
-            vec4(0.0, 0.0, 1.0, 0.0),
-            vec4(0.0, 0.0, 0.0, 1.0) };
+    //   c = math::cos(radians);
+    auto c = math::cos(radians);
+    auto s = math::sin(radians);
+    return {{vec4( c,   -s, 0.0, 0.0),
+             vec4( s,    c, 0.0, 0.0),
+             vec4(0.0, 0.0, 1.0, 0.0),
+             vec4(0.0, 0.0, 0.0, 1.0) }};
   }
 } // anonymous namespace
 
 namespace math
 {
-  std::map<std::string, Bisector> g_bisectorsMemo;
-
   decimal_t getEventY(Event const& e)
   {
     if (e.type == EventType_e::POINT)
@@ -123,32 +122,30 @@ namespace math
     return v1.x * v2.y - v1.y * v2.x;
   }
 
-  vec4 mult(std::vector<vec4> const& matrix, vec4 const& v4)
+  vec4 mult(std::array<vec4, 4> const& matrix, vec4 const& v4)
   {
-    std::vector<decimal_t> rslt;
-    for (auto&& row : matrix)
+    decimal_t rslt[4];
+    for (size_t i = 0; i < 4; ++i)
     {
+      auto const& row = matrix[i];
       decimal_t sum = 0.0;
       sum += row.x * v4.x;
       sum += row.y * v4.y;
       sum += row.z * v4.z;
       sum += row.w * v4.w;
-      rslt.push_back(sum);
+      rslt[i] = sum;
     }
     return vec4(rslt[0], rslt[1], rslt[2], rslt[3]);
   }
 
   bool isRightOfLine(vec2 const& upper, vec2 const& lower, vec2 const& p)
   {
-    auto v1 = vec2(upper.x - lower.x, upper.y - lower.y);
-    auto v2 = vec2(p.x - lower.x, p.y - lower.y);
-    auto z = crossProduct(v1, v2);
-    return z < 0;
+    return orient2d(lower, upper, p) < 0;
   }
 
-  std::vector<vec2> getPointsRightOfLine(vec2 const& a, vec2 const& b, std::vector<vec2> points)
+  candidates_t getPointsRightOfLine(vec2 const& a, vec2 const& b, candidates_t const& points)
   {
-    std::vector<vec2> rslt;
+    candidates_t rslt;
     for (auto&& p : points)
     {
       if (isRightOfLine(a,b,p))
@@ -157,9 +154,9 @@ namespace math
     return rslt;
   }
 
-  std::vector<vec2> getPointsLeftOfLine(vec2 const& a, vec2 const& b, std::vector<vec2> points)
+  candidates_t getPointsLeftOfLine(vec2 const& a, vec2 const& b, candidates_t const& points)
   {
-    std::vector<vec2> rslt;
+    candidates_t rslt;
     for (auto&& p : points)
     {
       if (!isRightOfLine(a,b,p))
@@ -173,7 +170,7 @@ namespace math
     return isRightOfLine(a1, b1, a2) && isRightOfLine(a1, b1, b2);
   }
 
-  std::vector<vec2> filterBySiteAssociation(Event const& s1, Event const& s2, Event const& s3, std::vector<vec2> const& points)
+  candidates_t filterBySiteAssociation(Event const& s1, Event const& s2, Event const& s3, candidates_t const& points)
   {
     // for each associated node
     auto sLeft = sharedSegment(s1, s2);
@@ -200,7 +197,7 @@ namespace math
     }
   }
 
-  std::vector<decimal_t> quadratic(decimal_t const& a, decimal_t const& b, decimal_t const& c)
+  roots_t quadratic(decimal_t const& a, decimal_t const& b, decimal_t const& c)
   {
     decimal_t thresh = 1e-3;
     if (a == 0.0) return {0.0};
@@ -208,10 +205,10 @@ namespace math
     if (disc < -thresh) {
       return {};
     }
-    if (std::abs(disc) < thresh) {
+    if (math::abs(disc) < thresh) {
       return {(-b)/(2*a)};
     }
-    auto sdisc = std::sqrt(disc);
+    auto sdisc = math::sqrt(disc);
     return {(-b+sdisc)/(2*a), (-b-sdisc)/(2*a)};
   }
 
@@ -259,7 +256,7 @@ namespace math
     return vec2(rslt.x, rslt.y); // Do we need z,w?
   }
 
-  std::vector<decimal_t> lpIntersect(decimal_t h, decimal_t k, decimal_t p, vec2 const& q, vec2 const& v)
+  roots_t lpIntersect(decimal_t h, decimal_t k, decimal_t p, vec2 const& q, vec2 const& v)
   {
     if (p == 0.0)
     {
@@ -274,7 +271,7 @@ namespace math
     return tvals;
   }
 
-  std::shared_ptr<vec2> intersectLines(vec2 const& p1, vec2 const& p2, vec2 const& p3, vec2 const& p4)
+  std::optional<vec2> intersectLines(vec2 const& p1, vec2 const& p2, vec2 const& p3, vec2 const& p4)
   {
     auto x1 = p1.x;
     auto x2 = p2.x;
@@ -286,17 +283,17 @@ namespace math
     auto y4 = p4.y;
     auto denom = (x1-x2)*(y3-y4)-(y1-y2)*(x3-x4);
     // originally 1e-6 but more precision has been needed
-    if (std::abs(denom) < 1e-14){
-      return nullptr;
+    if (math::abs(denom) < 1e-14){
+      return std::nullopt;
     }
     auto x = ((x1*y2-y1*x2)*(x3-x4) - (x1-x2)*(x3*y4-y3*x4))/denom;
     auto y = ((x1*y2-y1*x2)*(y3-y4) - (y1-y2)*(x3*y4-y3*x4))/denom;
-    return std::make_shared<vec2>(x, y);
+    return vec2(x, y);
   }
 
-  std::vector<vec2> intersectLeftRightLines(std::vector<Bisector> const& leftLines, std::vector<Bisector> const& rightLines)
+  candidates_t intersectLeftRightLines(bisectors_t const& leftLines, bisectors_t const& rightLines)
   {
-    std::vector<vec2> result;
+    candidates_t result;
     for (auto&& ll : leftLines)
     {
       for (auto&& rl : rightLines)
@@ -304,21 +301,21 @@ namespace math
         auto pOptIntersect = intersectLines(ll.p1, ll.p2, rl.p1, rl.p2);
         if (pOptIntersect)
         {
-          result.push_back(*pOptIntersect.get());
+          result.push_back(*pOptIntersect);
         }
       }
     }
     return result;
   }
 
-  std::vector<vec2> ppIntersect(decimal_t h1, decimal_t k1, decimal_t p1, decimal_t h2, decimal_t k2, decimal_t p2)
+  candidates_t ppIntersect(decimal_t h1, decimal_t k1, decimal_t p1, decimal_t h2, decimal_t k2, decimal_t p2)
   {
     // Check for degenerate parabolas
     // WATCH VALUE
     const double EPSILON = 0.00000001;
-    if (std::abs(p1) < EPSILON)
+    if (math::abs(p1) < EPSILON)
     {
-      if (std::abs(p2) < EPSILON)
+      if (math::abs(p2) < EPSILON)
       {
         // Both parabolas have no width
         return {};
@@ -327,7 +324,7 @@ namespace math
       auto y = parabola_f(x, h2, k2, p2);
       return {vec2(x, y)};
     }
-    else if (std::abs(p2) < EPSILON)
+    else if (math::abs(p2) < EPSILON)
     {
       auto x = h2;
       auto y = parabola_f(x, h1, k1, p1);
@@ -338,7 +335,7 @@ namespace math
     auto b = 0.5*(h2/p2 - h1/p1);
     auto c = 0.25*(h1*h1/p1 - h2*h2/p2) + k1 - k2;
     auto tvals = quadratic(a, b, c);
-    std::vector<vec2> ret;
+    candidates_t ret;
     for (auto&& x : tvals)
     {
       auto y = parabola_f(x, h1, k1, p1);//(x-h1)*(x-h1)/(4*p1) + k1;
@@ -347,7 +344,7 @@ namespace math
     return ret;
   }
 
-  std::vector<vec2> intersectRay(GeneralParabola const& genP, vec2 origin, vec2 v)
+  candidates_t intersectRay(GeneralParabola const& genP, vec2 origin, vec2 v)
   {
     auto p = transformPoint(origin, genP);
     auto vec = transformVector(v, genP);
@@ -355,10 +352,10 @@ namespace math
     auto tvals = lpIntersect(genP.h, genP.k, genP.p, p, vec);
     // Sort tvals in increasing order
     if (tvals.size() == 2 && tvals[1] < tvals[0]) {
-      tvals = {tvals[1], tvals[0]};
+      std::swap(tvals[0], tvals[1]);
     }
 
-    std::vector<vec2> ret;
+    candidates_t ret;
 
     for (auto&& t : tvals)
     {
@@ -380,7 +377,7 @@ namespace math
   }
 
   // The ray is given in parametric form p(t) = p + tv
-  std::vector<vec2> intersectRay(Parabola& para, vec2 p, vec2 v)
+  candidates_t intersectRay(Parabola& para, vec2 p, vec2 v)
   {
     if (para.p == 0.0)
     {
@@ -398,10 +395,10 @@ namespace math
     // Sort tvals in increasing order
     if (tvals.size() == 2 && tvals[1] < tvals[0])
     {
-      tvals = {tvals[1], tvals[0]};
+      std::swap(tvals[0], tvals[1]);
     }
 
-    std::vector<vec2> ret;
+    candidates_t ret;
     for (auto&& t : tvals)
     {
       auto q = vec2(p.x + (v.x * t), p.y + (v.y * t));
@@ -410,23 +407,23 @@ namespace math
     return ret;
   }
 
-  std::vector<vec2> vpIntersect(V const& v, Parabola& p)
+  candidates_t vpIntersect(V const& v, Parabola& p)
   {
-    std::vector<vec2> ret;
+    candidates_t ret;
     auto origin = v.point;
     // vectors are in parametric form
     for (auto vec : v.vectors)
     {
       auto o = intersectRay(p, origin, vec);
-      ret.insert(ret.end(), o.begin(), o.end());
+      for (auto&& i : o) ret.push_back(i);
     }
     return ret;
   }
 
-  std::vector<vec2> vvIntersect(V const& v1, V const& v2)
+  candidates_t vvIntersect(V const& v1, V const& v2)
   {
-    auto s1 = makeSegment(v1.b, v1.a, 0, true);
-    auto s2 = makeSegment(v2.b, v2.a, 0, true);
+    auto s1 = Event(v1.id, EventType_e::SEG, 0, vec2(0.0, 0.0), v1.b, v1.a);
+    auto s2 = Event(v2.id, EventType_e::SEG, 0, vec2(0.0, 0.0), v2.b, v2.a);
 
     auto optConnection = connected(s1, s2);
     if (optConnection) {
@@ -458,7 +455,7 @@ namespace math
       }
     } else {
       auto intersections = getLineIntersections(v1, v2);
-      std::vector<vec2> vPts;
+      candidates_t vPts;
       for (auto&& i : intersections)
       {
         if (i.y >= v1.point.y)
@@ -469,9 +466,9 @@ namespace math
     }
   }
 
-  std::vector<vec2> vbIntersect(V const& v, Bisector const& line)
+  candidates_t vbIntersect(V const& v, Bisector const& line)
   {
-    std::vector<vec2> ret;
+    candidates_t ret;
     auto origin = v.point;
     for (auto vec : v.vectors)
     {
@@ -488,9 +485,9 @@ namespace math
     auto p2 = s.a; // upper point
     if (p1.y == p2.y) return 0;
     if (consider_order && p1.y > p2.y) {
-      return std::atan2(p1.y-p2.y, p1.x-p2.x);
+      return math::atan2(p1.y-p2.y, p1.x-p2.x);
     }
-    return std::atan2(p2.y-p1.y, p2.x-p1.x);
+    return math::atan2(p2.y-p1.y, p2.x-p1.x);
   }
 
   bool dividesPoints(vec2 v, vec2 origin, vec2 p1, vec2 p2)
@@ -531,8 +528,8 @@ namespace math
       auto a2 = a.y - b.y;
       auto b2 = b.x - a.x;
       auto c = a.x * b.y - b.x * a.y;
-      auto n = std::abs(a2 * p.x + b2 * p.y + c);
-      auto dn = std::sqrt(a2*a2 + b2*b2);
+      auto n = math::abs(a2 * p.x + b2 * p.y + c);
+      auto dn = math::sqrt(a2*a2 + b2*b2);
       return n/dn;
     }
     else
@@ -541,7 +538,7 @@ namespace math
     }
   }
 
-  std::vector<vec2> filterVisiblePoints(Event const& site, std::vector<vec2> const& points)
+  candidates_t filterVisiblePoints(Event const& site, candidates_t const& points)
   {
     if (points.size() < 1) return {};
 
@@ -559,7 +556,7 @@ namespace math
       ((site.b.x-site.a.x) * tolerance) + site.a.x,
       ((site.b.y-site.a.y) * tolerance) + site.a.y);
 
-    std::vector<vec2> rslt;
+    candidates_t rslt;
     for (auto&& p : points)
     {
       if (fallsInBoundary(A,B,p))
@@ -614,6 +611,28 @@ namespace math
     return createGeneralBisector(p, a, b);
   }
 
+  SegmentV createSegmentV(vec2 p1, vec2 p2)
+  {
+    auto a = p1.y > p2.y ? p1 : p2;
+    auto b = p1.y > p2.y ? p2 : p1;
+    SegmentV sv;
+    sv.dx = a.x - b.x;
+    sv.dy = a.y - b.y;
+    sv.cross = a.x * b.y - a.y * b.x;
+
+    // the arms bisect the segment and any horizontal directrix
+    Event directrixSeg(EventType_e::SEG, 0, vec2(0.0,0.0), vec2(-1.0, 0.0), vec2(1.0, 0.0));
+    Event s1(EventType_e::SEG, 0, vec2(0.0,0.0), a, b);
+    auto theta = getSegmentsBisectorAngle(directrixSeg, s1);
+
+    auto PI = pi();
+    while (theta > 0) theta -= PI/2;
+    while (theta < 0) theta += PI/2;
+    sv.arms[0] = vec2(math::cos(theta + PI/2), math::sin(theta + PI/2));
+    sv.arms[1] = vec2(math::cos(theta), math::sin(theta));
+    return sv;
+  }
+
   double getSegmentsBisectorAngle(Event const& s, Event const& t)
   {
     auto stheta = getAngle(s, false);
@@ -645,7 +664,7 @@ namespace math
     return createLine(v1, v2);
   }
 
-  Bisector smallAngleBisectSegments(Event s1, Event s2, std::shared_ptr<vec2> optIntersect)
+  Bisector smallAngleBisectSegments(Event s1, Event s2, std::optional<vec2> optIntersect)
   {
     if (parallelTest(s1, s2))
     {
@@ -662,20 +681,20 @@ namespace math
     }
     else if (d2 < d1 && d2 < d3 && d2 < d4)
     {
-      s2 = makeSegment(s2.b, s2.a, 0, true);
+      s2 = Event(s2.id, EventType_e::SEG, 0, vec2(0.0, 0.0), s2.b, s2.a);
     }
     else if (d3 < d1 && d3 < d2 && d3 < d4)
     {
-      s1 = makeSegment(s1.b, s1.a, 0, true);
+      s1 = Event(s1.id, EventType_e::SEG, 0, vec2(0.0, 0.0), s1.b, s1.a);
     }
     else if (d4 < d1 && d4 < d2 && d4 < d3)
     {
-      s1 = makeSegment(s1.b, s1.a, 0, true);
-      s2 = makeSegment(s2.b, s2.a, 0, true);
+      s1 = Event(s1.id, EventType_e::SEG, 0, vec2(0.0, 0.0), s1.b, s1.a);
+      s2 = Event(s2.id, EventType_e::SEG, 0, vec2(0.0, 0.0), s2.b, s2.a);
     }
 
     auto beta = getSegmentsBisectorAngle(s1, s2);
-    auto v = vec2(std::cos(beta), std::sin(beta));
+    auto v = vec2(math::cos(beta), math::sin(beta));
     auto p = optIntersect ? optIntersect : intersectLines(s1.a, s1.b, s2.a, s2.b);
     if (!p)
     {
@@ -689,7 +708,7 @@ namespace math
   }
 
   // TODO performance - perhaps use memoization for segment bisectors?
-  std::vector<Bisector> bisectSegments2(Event const& s1, Event const& s2)
+  bisectors_t bisectSegments2(Event const& s1, Event const& s2)
   {
     // if connected segments
     auto optCon = connected(s1, s2);
@@ -720,15 +739,9 @@ namespace math
     return {bLine, createLine(v1, v2)};
   }
 
-   Bisector bisect(Event const& e1, Event const& e2)
+  Bisector bisect(Event const& e1, Event const& e2)
   {
-    auto abId = std::to_string(e1.id) + std::to_string(e2.id);
-    auto found = g_bisectorsMemo.find(abId);
-    if (found != g_bisectorsMemo.end())
-    {
-      return (*found).second;
-    }
-    Bisector b{false, nullptr, vec2(0.0, 0.0),
+    Bisector b{false, std::nullopt, vec2(0.0, 0.0),
               vec2(0.0, 0.0), vec2(0.0, 0.0)};
     if (e1.type == EventType_e::POINT && e2.type == EventType_e::POINT)
     {
@@ -746,11 +759,46 @@ namespace math
     {
       throw std::runtime_error("Invalid bisectors");
     }
-    g_bisectorsMemo.emplace(abId, b);
     return b;
   }
 
-  std::vector<vec2> intersect(Bisector const& a, Bisector const& b)
+  BisectorCache::BisectorCache(size_t capacity)
+    : m_index(), m_entries(), m_capacity(capacity)
+  {}
+
+  uint32_t BisectorCache::find(Event const& e1, Event const& e2)
+  {
+    auto k = key(e1, e2);
+    auto found = m_index.find(k);
+    if (found != m_index.end()) return found->second;
+
+    auto slot = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back({k, bisect(e1, e2)});
+    m_index.emplace(k, slot);
+    return slot;
+  }
+
+  Bisector const& BisectorCache::get(Event const& e1, Event const& e2)
+  {
+    return m_entries[find(e1, e2)].bisector;
+  }
+
+  Bisector const& BisectorCache::get(Event const& e1, Event const& e2, uint32_t& rSlot)
+  {
+    if (rSlot < m_entries.size() && m_entries[rSlot].key == key(e1, e2))
+      return m_entries[rSlot].bisector;
+    rSlot = find(e1, e2);
+    return m_entries[rSlot].bisector;
+  }
+
+  void BisectorCache::trim()
+  {
+    if (m_entries.size() <= m_capacity) return;
+    m_index.clear();
+    m_entries.clear();
+  }
+
+  candidates_t intersect(Bisector const& a, Bisector const& b)
   {
     if (a.isLine && b.isLine)
     {
@@ -779,9 +827,9 @@ namespace math
     return {};
   }
 
-  std::vector<vec2> equidistant(Event const& a, Event const& b, Event const& c)
+  candidates_t equidistant(Event const& a, Event const& b, Event const& c, BisectorCache& rBisectors)
   {
-    std::vector<Event> segments, points;
+    FixedVec<Event, 3> segments, points;
     for (auto&& e : {a,b,c})
     {
       if (e.type == EventType_e::POINT)
@@ -795,30 +843,29 @@ namespace math
       if (parallelTest(segments[0], segments[1]))
       {
         return intersect(getAverage(segments[0], segments[1]),
-          bisect(segments[0], points[0]));
+          rBisectors.get(segments[0], points[0]));
       }
       else
       {
         if (equiv2(points[0].point,segments[1].a) || equiv2(points[0].point ,segments[1].b))
         {
-          auto b1 = bisect(segments[1], points[0]); // line preferred
+          auto const& b1 = rBisectors.get(segments[1], points[0]); // line preferred
           auto blines = bisectSegments2(segments[0], segments[1]);
-          std::vector<vec2> ii;
-          for (auto&& line : blines)
+          // later bisectors' intersections come first
+          candidates_t ii;
+          for (auto line = blines.end(); line != blines.begin();)
           {
-            auto i = intersect(line, b1);
-            ii.insert(ii.begin(), i.begin(), i.end());
+            for (auto&& i : intersect(*--line, b1)) ii.push_back(i);
           }
           return ii;
         }
         // otherwise default
-        auto b1 = bisect(segments[0], points[0]);
+        auto const& b1 = rBisectors.get(segments[0], points[0]);
         auto blines = bisectSegments2(segments[0], segments[1]);
-        std::vector<vec2> ii;
-        for (auto&& line : blines)
+        candidates_t ii;
+        for (auto line = blines.end(); line != blines.begin();)
         {
-          auto i = intersect(line, b1);
-          ii.insert(ii.begin(), i.begin(), i.end());
+          for (auto&& i : intersect(*--line, b1)) ii.push_back(i);
         }
         return ii;
       }
@@ -827,9 +874,9 @@ namespace math
     {
       if (equiv2(points[1].point, segments[0].a) || equiv2(points[1].point, segments[0].b))
       {
-        return intersect(bisect(segments[0], points[1]), bisect(points[0], points[1]));
+        return intersect(rBisectors.get(segments[0], points[1]), rBisectors.get(points[0], points[1]));
       }
-      return intersect(bisect(segments[0], points[0]), bisect(points[0], points[1]));
+      return intersect(rBisectors.get(segments[0], points[0]), rBisectors.get(points[0], points[1]));
     }
     else if (segments.size() == 3)
     {
@@ -838,14 +885,18 @@ namespace math
       if (l.size() == 0 || r.size() == 0) return {};
       return intersectLeftRightLines(l, r);
     }
-    return intersect(bisect(a, b), bisect(b, c));
+    return intersect(rBisectors.get(a, b), rBisectors.get(b, c));
   }
 }
 
 /////////////////////// V
 V::V(vec2 p1, vec2 p2, decimal_t directrix, uint32_t id)
+  : V(p1, p2, math::createSegmentV(p1, p2), directrix, id)
+{}
+
+V::V(vec2 p1, vec2 p2, SegmentV const& sv, decimal_t directrix, uint32_t id)
   : point(0.0, 0.0), a(0.0, 0.0), b(0.0, 0.0),
-  vectors(), id(id)
+  vectors(sv.arms), id(id)
 {
   a = p2;
   b = p1;
@@ -854,20 +905,10 @@ V::V(vec2 p1, vec2 p2, decimal_t directrix, uint32_t id)
     a = p1;
     b = p2;
   }
-  Event directrixSeg(EventType_e::SEG, 0, vec2(0.0,0.0), vec2(-1.0, directrix), vec2(1.0, directrix));
-  auto optP = math::intersectLines(a, b, directrixSeg.a, directrixSeg.b);
-  if (!optP) throw std::runtime_error("Invalid V");
-  point = *optP;
-  Event s1(EventType_e::SEG, 0, vec2(0.0,0.0), a, b);
-  auto theta = math::getSegmentsBisectorAngle(directrixSeg, s1);
-
-  auto PI = math::pi();
-  while (theta > 0) theta -= PI/2;
-  while (theta < 0) theta += PI/2;
-  for (auto&& t : {theta + PI/2, theta})
-  {
-    vectors.push_back(vec2(std::cos(t), std::sin(t)));
-  }
+  // the segment line intersected with the directrix, same
+  // rounding as intersectLines with a horizontal line
+  if (math::abs(2.0 * sv.dy) < 1e-14) throw std::runtime_error("Invalid V");
+  point = vec2((sv.dx * directrix - sv.cross) / sv.dy, (sv.dy * directrix) / sv.dy);
 }
 
 decimal_t f_x(V const& v, decimal_t x)
@@ -881,13 +922,13 @@ decimal_t f_x(V const& v, decimal_t x)
   return v.point.y + vec.y * (x - v.point.x) / vec.x;
 }
 
-std::vector<decimal_t> f_y(V const& v, decimal_t y)
+roots_t f_y(V const& v, decimal_t y)
 {
   if (y < v.point.y) return {v.point.x};
   if (y == v.point.y) return {v.point.x};
   auto tY = v.point.y;
   auto tX = v.point.x;
-  std::vector<decimal_t> ret;
+  roots_t ret;
   for (auto&& vec : v.vectors)
   {
     ret.push_back(tX + vec.x*(y-tY)/vec.y);
@@ -905,11 +946,9 @@ Parabola::Parabola(vec2 focus, decimal_t h, decimal_t k, decimal_t p, uint32_t i
 
 GeneralParabola::GeneralParabola(vec2 focus, decimal_t h, decimal_t k,
                   decimal_t p, decimal_t theta, uint32_t id)
-  : focus(focus), h(h), k(k), p(p), theta(theta), Rz(), nRz(), id(id)
-{
-  Rz = rotateZ(-theta);
-  nRz = rotateZ(theta);
-}
+  : focus(focus), h(h), k(k), p(p), theta(theta),
+  Rz(rotateZ(-theta)), nRz(rotateZ(theta)), id(id)
+{}
 
 std::vector<vec2> prepDraw(V const& v,  decimal_t const& x0, decimal_t const& x1)
 {
@@ -959,3 +998,5 @@ std::vector<vec2> prepDraw(GeneralParabola const& p, vec2 const& origin, vec2 co
   }
   return drawPoints;
 }
+
+} // namespace GVD_SCALAR_NS
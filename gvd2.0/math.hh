@@ -1,30 +1,43 @@
 #ifndef MATH_HH
 #define MATH_HH
 
+#include "predicates.hh"
 #include "types.hh"
 
 #include <cmath>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+namespace GVD_SCALAR_NS
+{
+
+// Candidate lists of the intersection kernel. No query yields more
+// than 6 candidates so results are kept inline, see FixedVec.
+typedef FixedVec<vec2, 6> candidates_t;
+typedef FixedVec<decimal_t, 2> roots_t;
 
 struct V
 {
   V(vec2 p1, vec2 p2, decimal_t directrix, uint32_t id);
+  V(vec2 p1, vec2 p2, SegmentV const& sv, decimal_t directrix, uint32_t id);
 
   vec2 point;
   vec2 a;
   vec2 b;
-  std::vector<vec2> vectors;
+  std::array<vec2, 2> vectors;
   uint32_t id;
   // split site?
 };
 
 decimal_t f_x(V const& v, decimal_t x);
-std::vector<decimal_t> f_y(V const& v, decimal_t y);
+roots_t f_y(V const& v, decimal_t y);
 
 std::vector<vec2> prepDraw(V const& v, decimal_t const& x0, decimal_t const& x1);
 
@@ -51,8 +64,8 @@ struct GeneralParabola
   decimal_t k;
   decimal_t p;
   decimal_t theta;
-  std::vector<vec4> Rz;
-  std::vector<vec4> nRz;
+  std::array<vec4, 4> Rz;
+  std::array<vec4, 4> nRz;
   private:
   uint32_t id;
 };
@@ -72,7 +85,7 @@ namespace math
   {
     return a.x*b.x + a.y*b.y;
   }
-  inline decimal_t length(vec2 const &v) { return std::sqrt(dot(v,v)); }
+  inline decimal_t length(vec2 const &v) { return math::sqrt(dot(v,v)); }
 
   inline vec2 normalize(vec2 v)
   {
@@ -109,28 +122,37 @@ namespace math
   struct Bisector
   {
     bool isLine;
-    std::shared_ptr<GeneralParabola> optGeneralParabola;
+    std::optional<GeneralParabola> optGeneralParabola;
     vec2 p1;
     vec2 p2;
     vec2 v;
   };
 
   //////////////////////////// Create functions /////////////////////////
-  inline Event createEventFromNode(std::shared_ptr<Node> const& node)
+  inline Event createEventFromNode(Node const& node)
   {
     // DEBUG ONLY
-    // if (node->aType == ArcType_e::EDGE) throw std::runtime_error("Attempt to build event from edge!");
-    auto eType = node->aType == ArcType_e::ARC_PARA ? EventType_e::POINT : EventType_e::SEG;
-    return eType == EventType_e::POINT ?
-     Event(eType, node->label, node->point)
-     : Event(eType, node->label, vec2(0.0,0.0), node->a, node->b);
+    // if (node.aType == ArcType_e::EDGE) throw std::runtime_error("Attempt to build event from edge!");
+    // the id of the site, see BisectorCache
+    if (node.aType == ArcType_e::ARC_PARA)
+      return Event(node.site, EventType_e::POINT, node.label, node.point);
+    return Event(node.site, EventType_e::SEG, node.label, vec2(0.0,0.0), node.a, node.b);
   }
 
+  // directrix independent part of the V of the segment p1 p2
+  SegmentV createSegmentV(vec2 p1, vec2 p2);
+
   inline V createV(vec2 a, vec2 b, decimal_t directrix, uint32_t id)
   {
     return {a, b, directrix, id};
   }
 
+  // V of an ARC_V node using its precomputed segment constants
+  inline V createV(Node const& node, decimal_t directrix, uint32_t id)
+  {
+    return {node.a, node.b, node.v, directrix, id};
+  }
+
   inline Parabola createParabola(vec2 point, decimal_t directrix, uint32_t id)
   {
     // Parabola(vec2 focus, decimal_t h, decimal_t k, decimal_t p, uint32_t id);
@@ -142,7 +164,7 @@ namespace math
 
   inline Bisector createLine(vec2 p1, vec2 p2)
   {
-    return {true, nullptr, p1, p2, math::normalize(vec2(p2.x - p1.x, p2.y - p1.y))};
+    return {true, std::nullopt, p1, p2, math::normalize(vec2(p2.x - p1.x, p2.y - p1.y))};
   }
 
   inline Bisector createGeneralBisector(vec2 focus, vec2 a, vec2 b)
@@ -158,59 +180,65 @@ namespace math
     // splitSite = _.get(focus, "label") != _.get(directrix, "label");
     auto zHalf = z/2.0;
     return {false,
-            std::make_shared<GeneralParabola>(focus, focus.x,
-              zHalf, zHalf, std::atan2(v.y, v.x), g_id++),
+            GeneralParabola(focus, focus.x,
+              zHalf, zHalf, math::atan2(v.y, v.x), 0),
             vec2(0.0, 0.0), vec2(0.0, 0.0), vec2(0.0, 0.0)};
   }
 
-  inline std::shared_ptr<Node> createArcNode(Event const& event)
+  inline node_t createArcNode(Event const& event, NodeArena& rArena)
   {
     auto aType = event.type == EventType_e::SEG ? ArcType_e::ARC_V : ArcType_e::ARC_PARA;
-    auto pNode = std::make_shared<Node>(aType, event.label);
+    auto n = rArena.create(aType, event.label);
+    auto& node = rArena[n];
+    node.site = event.id;
     if (aType == ArcType_e::ARC_V)
     {
-      pNode->a = event.a;
-      pNode->b = event.b;
+      node.a = event.a;
+      node.b = event.b;
+      node.v = createSegmentV(event.a, event.b);
     }
     else
     {
-      pNode->point = event.point;
+      node.point = event.point;
     }
-    return pNode;
+    return n;
   }
 
-  inline std::shared_ptr<Node> createEdgeNode(std::shared_ptr<Node> l, std::shared_ptr<Node> r, vec2 startPt)
+  inline node_t createEdgeNode(node_t l, node_t r, vec2 startPt, NodeArena& rArena)
   {
-    auto pEdge = std::make_shared<Node>(ArcType_e::EDGE, 0);
-    pEdge->edgeStart = startPt;
-    pEdge->pLeft = l;
-    pEdge->pRight = r;
-    l->pParent = pEdge;
-    r->pParent = pEdge;
-    return pEdge;
+    auto e = rArena.create(ArcType_e::EDGE, 0);
+    auto& edge = rArena[e];
+    edge.edgeStart = startPt;
+    edge.left = l;
+    edge.right = r;
+    rArena[l].parent = e;
+    rArena[l].side = Side_e::LEFT;
+    rArena[r].parent = e;
+    rArena[r].side = Side_e::RIGHT;
+    return e;
   }
 
-  inline void setChild(std::shared_ptr<Node> parent, std::shared_ptr<Node> child, Side_e side)
+  inline void setChild(node_t parent, node_t child, Side_e side, NodeArena& rArena)
   {
     if (side == Side_e::LEFT) {
-      child->side = Side_e::LEFT;
-      parent->pLeft = child;
+      rArena[child].side = Side_e::LEFT;
+      rArena[parent].left = child;
     } else {
-      child->side = Side_e::RIGHT;
-      parent->pRight = child;
+      rArena[child].side = Side_e::RIGHT;
+      rArena[parent].right = child;
     }
-    child->pParent = parent;
+    rArena[child].parent = parent;
   }
 
-  inline std::shared_ptr<Node> getChild(std::shared_ptr<Node> parent, Side_e side)
+  inline node_t getChild(node_t parent, Side_e side, NodeArena const& arena)
   {
-    if (side == Side_e::LEFT) return parent->pLeft;
-    return parent->pRight;
+    if (side == Side_e::LEFT) return arena[parent].left;
+    return arena[parent].right;
   }
 
   inline bool equivD(decimal_t a, decimal_t b, decimal_t error_factor=1.0)
   {
-    return a==b || std::abs(a - b) < std::abs(std::min(a,b)) * std::numeric_limits<decimal_t>::epsilon() * error_factor;
+    return a==b || math::abs(a - b) < math::abs(std::min(a,b)) * math::epsilon() * error_factor;
   }
 
   inline bool equiv2(vec2 const& a, vec2 const& b)
@@ -218,12 +246,13 @@ namespace math
     return equivD(a.x, b.x) && equivD(a.y, b.y);
   }
 
-  inline std::shared_ptr<Event> sharedSegment(Event const& s1, Event const& s2)
+  // the segment of s1, s2 if the other is one of its endpoints
+  inline Event const* sharedSegment(Event const& s1, Event const& s2)
   {
     if (s1.type == EventType_e::POINT && s2.type == EventType_e::SEG) {
-      return equiv2(s1.point, s2.a) || equiv2(s1.point, s2.b) ? std::make_shared<Event>(s2) : nullptr;
+      return equiv2(s1.point, s2.a) || equiv2(s1.point, s2.b) ? &s2 : nullptr;
     } else if (s2.type == EventType_e::POINT && s1.type == EventType_e::SEG) {
-      return equiv2(s1.a, s2.point) || equiv2(s1.b, s2.point) ? std::make_shared<Event>(s1) : nullptr;
+      return equiv2(s1.a, s2.point) || equiv2(s1.b, s2.point) ? &s1 : nullptr;
     }
     return nullptr;
   }
@@ -233,19 +262,19 @@ namespace math
     return length(vec2(a.x - b.x, a.y - b.y));
   }
 
-  vec4 mult(std::vector<vec4> const& matrix, vec4 const& v4);
+  vec4 mult(std::array<vec4, 4> const& matrix, vec4 const& v4);
 
   bool isRightOfLine(vec2 const& upper, vec2 const& lower, vec2 const& p);
 
-  std::vector<vec2> getPointsRightOfLine(vec2 const& a, vec2 const& b, std::vector<vec2> points);
+  candidates_t getPointsRightOfLine(vec2 const& a, vec2 const& b, candidates_t const& points);
 
-  std::vector<vec2> getPointsLeftOfLine(vec2 const& a, vec2 const& b, std::vector<vec2> points);
+  candidates_t getPointsLeftOfLine(vec2 const& a, vec2 const& b, candidates_t const& points);
 
   bool dividesRightOfLine(vec2 const& a1, vec2 const& b1, vec2 const& a2, vec2 const& b2);
 
-  std::vector<vec2> filterBySiteAssociation(Event const& s1, Event const& s2, Event const& s3, std::vector<vec2> const& points);
+  candidates_t filterBySiteAssociation(Event const& s1, Event const& s2, Event const& s3, candidates_t const& points);
 
-  std::vector<decimal_t> quadratic(decimal_t const& a, decimal_t const& b, decimal_t const& c);
+  roots_t quadratic(decimal_t const& a, decimal_t const& b, decimal_t const& c);
 
   vec2 transformVector(vec2 v, GeneralParabola const& genP);
 
@@ -253,25 +282,24 @@ namespace math
 
   vec2 untransformPoint(vec2 p, GeneralParabola const& genP);
 
-  std::vector<decimal_t> lpIntersect(decimal_t h, decimal_t k, decimal_t p, vec2 const& q, vec2 const& v);
+  roots_t lpIntersect(decimal_t h, decimal_t k, decimal_t p, vec2 const& q, vec2 const& v);
 
-  std::shared_ptr<vec2> intersectLines(vec2 const& p1, vec2 const& p2, vec2 const& p3, vec2 const& p4);
-  std::vector<vec2> intersectLeftRightLines(std::vector<Bisector> const& leftLines, std::vector<Bisector> const& rightLines);
+  std::optional<vec2> intersectLines(vec2 const& p1, vec2 const& p2, vec2 const& p3, vec2 const& p4);
+  typedef FixedVec<Bisector, 2> bisectors_t;
+  candidates_t intersectLeftRightLines(bisectors_t const& leftLines, bisectors_t const& rightLines);
 
-  std::vector<vec2> ppIntersect(decimal_t h1, decimal_t k1, decimal_t p1, decimal_t h2, decimal_t k2, decimal_t p2);
+  candidates_t ppIntersect(decimal_t h1, decimal_t k1, decimal_t p1, decimal_t h2, decimal_t k2, decimal_t p2);
 
-  std::vector<vec2> intersectRay(GeneralParabola const& genP, vec2 origin, vec2 v);
-  std::vector<vec2> intersectRay(Parabola& para, vec2 p, vec2 v);
+  candidates_t intersectRay(GeneralParabola const& genP, vec2 origin, vec2 v);
+  candidates_t intersectRay(Parabola& para, vec2 p, vec2 v);
 
-  std::vector<vec2> vpIntersect(V const& v, Parabola& p);
-  std::vector<vec2> vvIntersect(V const& v1, V const& v2);
-  std::vector<vec2> vbIntersect(V const& v, Bisector const& line);
+  candidates_t vpIntersect(V const& v, Parabola& p);
+  candidates_t vvIntersect(V const& v1, V const& v2);
+  candidates_t vbIntersect(V const& v, Bisector const& line);
 
   inline bool betweenValue(decimal_t t, decimal_t a, decimal_t b)
   {
-    std::vector<decimal_t> v = {a, b};
-    std::sort(v.begin(), v.end());
-    return v[0] <= t && t <= v[1];
+    return std::min(a, b) <= t && t <= std::max(a, b);
   }
 
   double getAngle(Event s, bool consider_order=true);
@@ -284,28 +312,28 @@ namespace math
     // distance from p to line(a-b)
   decimal_t distLine(vec2 p, vec2 a, vec2 b);
 
-  std::vector<vec2> filterVisiblePoints(Event const& site, std::vector<vec2> const& points);
+  candidates_t filterVisiblePoints(Event const& site, candidates_t const& points);
 
   bool intersectsTargetSegments(Event const& s1, Event const& s2);
 
   inline double getAngleBetweenTwoVec(vec2 v1, vec2 v2)
   {
     auto d = dot(v1, v2);
-    auto m1 = std::sqrt(v1.x * v1.x + v1.y * v1.y);
-    auto m2 = std::sqrt(v2.x * v2.x + v2.y * v2.y);
-    return std::acos(d/m1*m2);
+    auto m1 = math::sqrt(v1.x * v1.x + v1.y * v1.y);
+    auto m2 = math::sqrt(v2.x * v2.x + v2.y * v2.y);
+    return math::acos(d/m1*m2);
   }
 
-  inline std::shared_ptr<vec2> connected(Event const& s1, Event const& s2)
+  inline std::optional<vec2> connected(Event const& s1, Event const& s2)
   {
     if (equiv2(s1.a, s2.a) || equiv2(s1.a, s2.b)) {
-      return std::make_shared<vec2>(s1.a);
+      return s1.a;
     }
     else if (equiv2(s1.b, s2.a) || equiv2(s1.b, s2.b))
     {
-      return std::make_shared<vec2>(s1.b);
+      return s1.b;
     }
-    return nullptr;
+    return std::nullopt;
   }
 
   Bisector bisectPointSegment(vec2 p, vec2 a, vec2 b);
@@ -314,8 +342,8 @@ namespace math
 
   Bisector bisectPoints(vec2 p1, vec2 p2);
 
-  Bisector smallAngleBisectSegments(Event s1, Event s2, std::shared_ptr<vec2> optIntersect = nullptr);
-  std::vector<Bisector> bisectSegments2(Event const& s1, Event const& s2);
+  Bisector smallAngleBisectSegments(Event s1, Event s2, std::optional<vec2> optIntersect = std::nullopt);
+  bisectors_t bisectSegments2(Event const& s1, Event const& s2);
 
   inline bool parallelTest(Event const& s1, Event const& s2)
   {
@@ -333,9 +361,51 @@ namespace math
 
   Bisector bisect(Event const& e1, Event const& e2);
 
-  std::vector<vec2> intersect(Bisector const& a, Bisector const& b);
+  //------------------------------------------------------------
+  // BisectorCache
+  // Per-run bisectors keyed by the ordered pair of site ids.
+  // Entries do not move so references stay valid until trim().
+  // An edge keeps the slot of the bisector of its bounding arcs
+  // in Node::bisector, the slot is checked against the key as
+  // the arcs around an edge change.
+  //------------------------------------------------------------
+  class BisectorCache
+  {
+  public:
+    explicit BisectorCache(size_t capacity = 1 << 16);
+
+    // bisector of e1 and e2, built on a miss
+    Bisector const& get(Event const& e1, Event const& e2);
+    // same, looking in and updating an edge's slot first
+    Bisector const& get(Event const& e1, Event const& e2, uint32_t& rSlot);
+
+    // drops every entry once more than capacity are cached,
+    // only call when no references are held
+    void trim();
+    size_t size() const { return m_entries.size(); }
 
-  std::vector<vec2> equidistant(Event const& a, Event const& b, Event const& c);
+  private:
+    struct Entry
+    {
+      uint64_t key;
+      Bisector bisector;
+    };
+
+    static uint64_t key(Event const& e1, Event const& e2)
+    {
+      return (static_cast<uint64_t>(e1.id) << 32) | e2.id;
+    }
+
+    uint32_t find(Event const& e1, Event const& e2);
+
+    std::unordered_map<uint64_t, uint32_t> m_index;
+    std::deque<Entry> m_entries;
+    size_t m_capacity;
+  };
+
+  candidates_t intersect(Bisector const& a, Bisector const& b);
+
+  candidates_t equidistant(Event const& a, Event const& b, Event const& c, BisectorCache& rBisectors);
 
   //////////////////////// Sorting structs ////////////////////////////
   struct vec2_x_less_than
@@ -356,9 +426,7 @@ namespace math
         if (math::equiv2(lhs.a, rhs.a))
         {
           // auto r = math::isRightOfLine(lhs.a, lhs.b, rhs.b);
-          auto v1 = vec2(lhs.a.x - lhs.b.x, lhs.a.y - lhs.b.y);
-          auto v2 = vec2(rhs.b.x - lhs.b.x, rhs.b.y - lhs.b.y);
-          auto z = crossProduct(v1, v2);
+          auto z = orient2d(lhs.b, lhs.a, rhs.b);
           if (z == 0.0) return lhs.b.y < rhs.b.y;
           return z < 0.0;
         }
@@ -381,4 +449,6 @@ namespace math
   };
 }
 
-#endif
\ No newline at end of file
+} // namespace GVD_SCALAR_NS
+
+#endif
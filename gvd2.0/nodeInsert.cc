@@ -2,24 +2,25 @@
 
 #include "math.hh"
 
+namespace GVD_SCALAR_NS
+{
+
 namespace
 {
   bool isLeftHull(vec2 const& sLowerA, vec2 const& sLowerB, vec2 const& sUpperA)
   {
-    auto v0 = vec2(sUpperA.x - sLowerA.x, sUpperA.y - sLowerA.y);
-    auto v1 = vec2(sLowerB.x - sLowerA.x, sLowerB.y - sLowerA.y);
-    return math::crossProduct(v0, v1) < 0;
+    return math::orient2d(sLowerA, sUpperA, sLowerB) < 0;
   }
 
   // c++ form of isClosing()
-  std::shared_ptr<bool> isClosingRight(std::shared_ptr<Node> child, vec2 const& p)
+  std::optional<bool> isClosingRight(node_t child, vec2 const& p, NodeArena const& arena)
   {
 
-    auto r = child->nextArc();
+    auto r = arena.nextArc(child);
     // auto c = child.optSite;
-    auto l = child->prevArc();
+    auto l = arena.prevArc(child);
 
-    if (!r || !l) return nullptr;
+    if (r == NULL_NODE || l == NULL_NODE) return std::nullopt;
 
     // /* cases:
     // 1. l and c are segments and end at p
@@ -27,220 +28,355 @@ namespace
     // 2. l and r are segments and end at p
     // */
 
-    if (child->aType == ArcType_e::ARC_V && r->aType == ArcType_e::ARC_V)
+    auto const& c = arena[child];
+    if (c.aType == ArcType_e::ARC_V && arena[r].aType == ArcType_e::ARC_V)
     {
-      if (math::equiv2(r->b, p) && math::equiv2(child->b, p)) return std::make_shared<bool>(true);
+      if (math::equiv2(arena[r].b, p) && math::equiv2(c.b, p)) return true;
     }
 
-    if (l->aType == ArcType_e::ARC_V && child->aType == ArcType_e::ARC_V)
+    if (arena[l].aType == ArcType_e::ARC_V && c.aType == ArcType_e::ARC_V)
     {
-      if (math::equiv2(l->b, p) && math::equiv2(child->b, p)) return std::make_shared<bool>(false);
+      if (math::equiv2(arena[l].b, p) && math::equiv2(c.b, p)) return false;
     }
 
     // if (l.type === "segment" && c.type === "segment") {
     //   if (math::equiv2(l.b, p.point) && math::equiv2(c.b, p.point)) return std::make_shared<bool>(true);
     // }
-    return nullptr;
+    return std::nullopt;
   }
 
-  std::shared_ptr<Node> createNewEdge(std::shared_ptr<Node> left, std::shared_ptr<Node> right, vec2 vertex,
-                                      std::vector<CloseEvent>& rCQueue)
+  node_t createNewEdge(node_t left, node_t right, vec2 vertex,
+                       NodeArena& rArena, CloseEventQueue& rCQueue)
   {
     // left->live = false;
     // right->live = false;
-    removeCloseEventFromQueue(left->id, rCQueue);
-    removeCloseEventFromQueue(right->id, rCQueue);
-    return math::createEdgeNode(left, right, vertex);
+    rCQueue.cancel(left, rArena);
+    rCQueue.cancel(right, rArena);
+    return math::createEdgeNode(left, right, vertex, rArena);
   }
 
-  std::shared_ptr<Node> closePointSplit(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
+  node_t closePointSplit(node_t left, node_t right, NodeArena& rArena)
   {
-    if (left->aType == ArcType_e::ARC_V && right->aType == ArcType_e::ARC_PARA)
+    auto const& l = rArena[left];
+    auto const& r = rArena[right];
+    if (l.aType == ArcType_e::ARC_V && r.aType == ArcType_e::ARC_PARA)
     {
-      return math::createEdgeNode(left, right, right->point);
+      return math::createEdgeNode(left, right, r.point, rArena);
     }
-    else if (left->aType == ArcType_e::ARC_PARA && right->aType == ArcType_e::ARC_V)
+    else if (l.aType == ArcType_e::ARC_PARA && r.aType == ArcType_e::ARC_V)
     {
-      return math::createEdgeNode(left, right, left->point);
+      return math::createEdgeNode(left, right, l.point, rArena);
     }
 
     throw std::runtime_error("Invalid close joint split");
-    return nullptr;
+    return NULL_NODE;
   }
 
-  std::shared_ptr<Node> splitArcNode(std::shared_ptr<Node> toSplit,
-    std::shared_ptr<Node> node, std::vector<std::shared_ptr<Node>>& nodesToClose,
-    std::vector<CloseEvent>& rCQueue)
+  // copy of an arc used for the right hand side of a split
+  node_t copyArcNode(node_t toSplit, NodeArena& rArena)
+  {
+    auto n = rArena.create(rArena[toSplit].aType, rArena[toSplit].label);
+    auto const& s = rArena[toSplit];
+    auto& copy = rArena[n];
+    copy.point = s.point;
+    copy.a = s.a;
+    copy.b = s.b;
+    copy.v = s.v;
+    copy.site = s.site;
+    return n;
+  }
+
+  node_t splitArcNode(node_t toSplit,
+    node_t node, closingNodes_t& nodesToClose,
+    NodeArena& rArena, CloseEventQueue& rCQueue)
   {
     // toSplit->live = false;
-    removeCloseEventFromQueue(toSplit->id, rCQueue);
+    rCQueue.cancel(toSplit, rArena);
     vec2 vertex(0.0, 0.0);
-    if (node->aType == ArcType_e::ARC_V)
+    auto const& s = rArena[toSplit];
+    auto const& n = rArena[node];
+    if (n.aType == ArcType_e::ARC_V)
     {
-      vertex = node->a;
+      vertex = n.a;
     }
     else
     {
-      auto x = node->point.x;
+      auto x = n.point.x;
       decimal_t y;
-      if (toSplit->aType == ArcType_e::ARC_PARA)
+      if (s.aType == ArcType_e::ARC_PARA)
       {
-        auto d = toSplit->point.y == node->point.y ? node->point.y - 1e-10: node->point.y;
-        auto h = toSplit->point.x;
-        auto k = (d + toSplit->point.y) / 2;
-        auto p = (toSplit->point.y - d) / 2;
+        auto d = s.point.y == n.point.y ? n.point.y - 1e-10: n.point.y;
+        auto h = s.point.x;
+        auto k = (d + s.point.y) / 2;
+        auto p = (s.point.y - d) / 2;
         y = math::parabola_f(x, h, k, p);
       }
       else // else to split is a V
       {
-        V obj(toSplit->a, toSplit->b, node->point.y, g_nodeId++);
+        V obj(s.a, s.b, s.v, n.point.y, toSplit);
         y = f_x(obj, x);
       }
       vertex = vec2(x, y);
     }
-    auto eType = toSplit->aType == ArcType_e::ARC_PARA ? EventType_e::POINT : EventType_e::SEG;
-    auto newEvent = eType == EventType_e::POINT ?
-     Event(eType, toSplit->label, toSplit->point)
-     : Event(eType, toSplit->label, vec2(0.0,0.0), toSplit->a, toSplit->b);
-    auto right = math::createArcNode(newEvent);
+    auto right = copyArcNode(toSplit, rArena);
 
     nodesToClose.push_back(toSplit);
     nodesToClose.push_back(right);
-    auto rightEdge = math::createEdgeNode(node, right, vertex);
-    return math::createEdgeNode(toSplit, rightEdge, vertex);
+    auto rightEdge = math::createEdgeNode(node, right, vertex, rArena);
+    return math::createEdgeNode(toSplit, rightEdge, vertex, rArena);
   }
 
-  std::shared_ptr<Node> insertEdge(std::shared_ptr<Node> toSplit, std::shared_ptr<Node> edge,
-        vec2 vertex, std::vector<std::shared_ptr<Node>>& nodesToClose,
-        std::vector<CloseEvent>& rCQueue, bool addCloseNodes = true)
+  node_t insertEdge(node_t toSplit, node_t edge,
+        vec2 vertex, closingNodes_t& nodesToClose,
+        NodeArena& rArena, CloseEventQueue& rCQueue, bool addCloseNodes = true)
   {
     // toSplit->live = false;
-    removeCloseEventFromQueue(toSplit->id, rCQueue);
-    auto eType = toSplit->aType == ArcType_e::ARC_PARA ? EventType_e::POINT : EventType_e::SEG;
-    auto newEvent = eType == EventType_e::POINT ?
-     Event(eType, toSplit->label, toSplit->point)
-     : Event(eType, toSplit->label, vec2(0.0,0.0), toSplit->a, toSplit->b);
-    auto right = math::createArcNode(newEvent);
+    rCQueue.cancel(toSplit, rArena);
+    auto right = copyArcNode(toSplit, rArena);
     if (addCloseNodes)
     {
       nodesToClose.push_back(toSplit);
       nodesToClose.push_back(right);
     }
-    auto rightEdge = math::createEdgeNode(edge, right, vertex);
-    return math::createEdgeNode(toSplit, rightEdge, vertex);
+    auto rightEdge = math::createEdgeNode(edge, right, vertex, rArena);
+    return math::createEdgeNode(toSplit, rightEdge, vertex, rArena);
   }
 
   // Child is guaranteed to be the parabola arc
-  std::shared_ptr<Node> VRegularInsert(std::shared_ptr<Node> arcNode,
-              std::shared_ptr<Node> childArcNode, std::shared_ptr<Node> parentV,
-              std::vector<CloseEvent>& rCQueue)
+  node_t VRegularInsert(node_t arcNode,
+              node_t childArcNode, node_t parentV,
+              NodeArena& rArena, CloseEventQueue& rCQueue)
   {
-    auto left = isLeftHull(childArcNode->a, childArcNode->b, parentV->a);
+    auto const& c = rArena[childArcNode];
+    auto left = isLeftHull(c.a, c.b, rArena[parentV].a);
     if (left) {
       // // Set edge information since we are using a left joint split
-      auto nextEdge = arcNode->nextEdge();
+      // auto nextEdge = arcNode->nextEdge();
       // if (nextEdge) nextEdge.dcelEdge.generalEdge = false;
-      return createNewEdge(arcNode, childArcNode, childArcNode->a, rCQueue);
+      return createNewEdge(arcNode, childArcNode, c.a, rArena, rCQueue);
     } else {
       // // Set edge information since we are using a right joint split
-      auto prevEdge = arcNode->prevEdge();
+      // auto prevEdge = arcNode->prevEdge();
       // if (prevEdge) prevEdge.dcelEdge.generalEdge = false;
       // is a arc created by the right hull joint
-      return createNewEdge(childArcNode, arcNode, childArcNode->a, rCQueue);
+      return createNewEdge(childArcNode, arcNode, c.a, rArena, rCQueue);
     }
   }
 
-  std::shared_ptr<Node> ParaInsert(std::shared_ptr<Node> child, std::shared_ptr<Node> arcNode,
-                                  std::vector<std::shared_ptr<Node>>& nodesToClose,
-                                  std::vector<CloseEvent>& rCQueue)
+  node_t ParaInsert(node_t child, node_t arcNode,
+                    closingNodes_t& nodesToClose,
+                    NodeArena& rArena, CloseEventQueue& rCQueue)
   {
-    std::shared_ptr<Node> newChild = nullptr;
+    node_t newChild = NULL_NODE;
     // TODO performance - most nodes will not need this
-    auto closingData = isClosingRight(child, arcNode->point);
+    auto closingData = isClosingRight(child, rArena[arcNode].point, rArena);
     if (closingData)
     {
       // DEBUG ONLY
-      if (child->aType != ArcType_e::ARC_V) throw std::runtime_error("Invalid node insertion");
-      auto edgeToUpdate = child->prevEdge();
+      if (rArena[child].aType != ArcType_e::ARC_V) throw std::runtime_error("Invalid node insertion");
+      auto edgeToUpdate = rArena.prevEdge(child);
       if (*closingData)
       {
-        edgeToUpdate = child->nextEdge();
+        edgeToUpdate = rArena.nextEdge(child);
       }
-      if (edgeToUpdate)
+      if (edgeToUpdate != NULL_NODE)
       {
-        edgeToUpdate->overridden = true;
-        edgeToUpdate->edgeStart = arcNode->point; // General parabola points?
+        rArena[edgeToUpdate].overridden = true;
+        rArena[edgeToUpdate].edgeStart = rArena[arcNode].point; // General parabola points?
       }
       nodesToClose.push_back(child);
       if (*closingData)
       {
-        nodesToClose.push_back(child->nextArc());
-        newChild = closePointSplit(child, arcNode);
+        nodesToClose.push_back(rArena.nextArc(child));
+        newChild = closePointSplit(child, arcNode, rArena);
       }
       else
       {
-        nodesToClose.push_back(child->prevArc());
-        newChild = closePointSplit(arcNode, child);
+        nodesToClose.push_back(rArena.prevArc(child));
+        newChild = closePointSplit(arcNode, child, rArena);
       }
     }
     else
     {
-      newChild = splitArcNode(child, arcNode, nodesToClose, rCQueue);
+      newChild = splitArcNode(child, arcNode, nodesToClose, rArena, rCQueue);
     }
     return newChild;
   }
+
+  // thread the in-order sequence of a generated subtree after rLast
+  void threadSubTree(node_t n, node_t& rLast, NodeArena& rArena)
+  {
+    auto isEdge = rArena[n].aType == ArcType_e::EDGE;
+    if (isEdge) threadSubTree(rArena[n].left, rLast, rArena);
+    rArena.link(rLast, n);
+    rLast = n;
+    if (isEdge) threadSubTree(rArena[n].right, rLast, rArena);
+  }
+}
+
+namespace
+{
+  uint32_t height(node_t n, NodeArena const& arena)
+  {
+    return n == NULL_NODE ? 0 : arena[n].height;
+  }
+
+  void updateHeight(node_t n, NodeArena& rArena)
+  {
+    auto& node = rArena[n];
+    node.height = 1 + std::max(height(node.left, rArena), height(node.right, rArena));
+    node.arcs = rArena[node.left].arcs + rArena[node.right].arcs;
+  }
+
+  // rotate the heavy child of n up into its place, returns the new subtree root
+  node_t rotate(node_t n, Side_e heavySide, NodeArena& rArena)
+  {
+    auto lightSide = heavySide == Side_e::LEFT ? Side_e::RIGHT : Side_e::LEFT;
+    auto parent = rArena[n].parent;
+    auto parentSide = (parent != NULL_NODE && rArena[parent].left == n) ? Side_e::LEFT : Side_e::RIGHT;
+    auto top = math::getChild(n, heavySide, rArena);
+
+    math::setChild(n, math::getChild(top, lightSide, rArena), heavySide, rArena);
+    math::setChild(top, n, lightSide, rArena);
+    if (parent != NULL_NODE)
+      math::setChild(parent, top, parentSide, rArena);
+    else
+    {
+      rArena[top].parent = NULL_NODE;
+      rArena[top].side = Side_e::UNDEFINED;
+    }
+
+    updateHeight(n, rArena);
+    updateHeight(top, rArena);
+    return top;
+  }
+
+  // AVL fix up of an edge node whose children are balanced. A spliced
+  // subtree can be several levels taller than its sibling so the nodes
+  // pushed down by a rotation are fixed up again.
+  node_t balanceNode(node_t n, NodeArena& rArena)
+  {
+    updateHeight(n, rArena);
+    auto diff = static_cast<int>(height(rArena[n].left, rArena))
+      - static_cast<int>(height(rArena[n].right, rArena));
+    if (std::abs(diff) <= 1) return n;
+
+    auto heavySide = diff > 0 ? Side_e::LEFT : Side_e::RIGHT;
+    auto lightSide = diff > 0 ? Side_e::RIGHT : Side_e::LEFT;
+    auto child = math::getChild(n, heavySide, rArena);
+    if (height(math::getChild(child, heavySide, rArena), rArena)
+        < height(math::getChild(child, lightSide, rArena), rArena))
+    {
+      rotate(child, lightSide, rArena);
+      balanceNode(child, rArena);
+      updateHeight(math::getChild(n, heavySide, rArena), rArena);
+    }
+    auto top = rotate(n, heavySide, rArena);
+    balanceNode(n, rArena);
+    return balanceNode(top, rArena);
+  }
+}
+
+node_t balanceSubTree(node_t subRoot, NodeArena& rArena)
+{
+  // generated subtrees only hold a handful of new edges
+  if (rArena[subRoot].aType != ArcType_e::EDGE) return subRoot;
+  balanceSubTree(rArena[subRoot].left, rArena);
+  balanceSubTree(rArena[subRoot].right, rArena);
+  return balanceNode(subRoot, rArena);
+}
+
+void rebalance(node_t n, node_t& rRoot, NodeArena& rArena)
+{
+  while (n != NULL_NODE)
+  {
+    // the arc counts change up to the root even where the heights stay
+    auto top = balanceNode(n, rArena);
+    auto parent = rArena[top].parent;
+    if (parent == NULL_NODE)
+      rRoot = top;
+    n = parent;
+  }
+}
+
+node_t arcAt(node_t root, uint32_t index, NodeArena const& arena)
+{
+  auto n = root;
+  while (arena[n].aType == ArcType_e::EDGE)
+  {
+    auto const& node = arena[n];
+    auto leftArcs = arena[node.left].arcs;
+    if (index < leftArcs)
+      n = node.left;
+    else
+    {
+      index -= leftArcs;
+      n = node.right;
+    }
+  }
+  return n;
 }
 
 SubTreeRslt generateSubTree(EventPacket const& e,
-                                      std::shared_ptr<Node> arcNode,
-                                      std::vector<CloseEvent>& rCQueue,
-                                      std::shared_ptr<Node> optChild)
+                                      node_t arcNode,
+                                      NodeArena& rArena,
+                                      CloseEventQueue& rCQueue,
+                                      node_t optChild)
 {
-  auto tree = std::make_shared<Node>(ArcType_e::UNDEFINED, 0);
-  std::vector<std::shared_ptr<Node>> nodesToClose;
+  node_t tree = NULL_NODE;
+  closingNodes_t nodesToClose;
+  // the subtree takes the place of optChild in the in-order thread
+  auto before = optChild != NULL_NODE ? rArena[optChild].prev : NULL_NODE;
+  auto after = optChild != NULL_NODE ? rArena[optChild].next : NULL_NODE;
 
   if (e.children.size() == 2)
   {
-    auto leftArcNode = math::createArcNode(e.children[0]);
-    auto rightArcNode = math::createArcNode(e.children[1]);
-    auto newEdge = math::createEdgeNode(leftArcNode, rightArcNode, arcNode->point);
-    if (optChild)
+    auto leftArcNode = math::createArcNode(e.children[0], rArena);
+    auto rightArcNode = math::createArcNode(e.children[1], rArena);
+    auto newEdge = math::createEdgeNode(leftArcNode, rightArcNode, rArena[arcNode].point, rArena);
+    if (optChild != NULL_NODE)
     {
-      tree = splitArcNode(optChild, arcNode, nodesToClose, rCQueue);
-      auto childEdge = insertEdge(arcNode, newEdge, arcNode->point, nodesToClose, rCQueue);
-      math::setChild(tree->pRight, childEdge, Side_e::LEFT);
+      tree = splitArcNode(optChild, arcNode, nodesToClose, rArena, rCQueue);
+      auto childEdge = insertEdge(arcNode, newEdge, rArena[arcNode].point, nodesToClose, rArena, rCQueue);
+      math::setChild(rArena[tree].right, childEdge, Side_e::LEFT, rArena);
     }
     else
-      tree = insertEdge(arcNode, newEdge, arcNode->point, nodesToClose, rCQueue, false);
+      tree = insertEdge(arcNode, newEdge, rArena[arcNode].point, nodesToClose, rArena, rCQueue, false);
   }
   else if (e.children.size() == 1)
   {
-    if (optChild && optChild->aType == ArcType_e::ARC_V) {
+    if (optChild != NULL_NODE && rArena[optChild].aType == ArcType_e::ARC_V) {
       // if (!optChild.isV) throw 'Invalid insert operation';
-      auto childArcNode = math::createArcNode(e.children[0]);
-      tree = splitArcNode(optChild, arcNode, nodesToClose, rCQueue);
-      auto parent = arcNode->pParent;
-      auto newEdge = VRegularInsert(arcNode, childArcNode, optChild, rCQueue);
-      math::setChild(parent, newEdge, Side_e::LEFT);
-    } else if (optChild) {
-      tree = splitArcNode(optChild, arcNode, nodesToClose, rCQueue);
-      auto parent = arcNode->pParent;
-      auto childArcNode = math::createArcNode(e.children[0]);
-      auto newEdge = splitArcNode(arcNode, childArcNode, nodesToClose, rCQueue);
-      math::setChild(parent, newEdge, Side_e::LEFT);
+      auto childArcNode = math::createArcNode(e.children[0], rArena);
+      tree = splitArcNode(optChild, arcNode, nodesToClose, rArena, rCQueue);
+      auto parent = rArena[arcNode].parent;
+      auto newEdge = VRegularInsert(arcNode, childArcNode, optChild, rArena, rCQueue);
+      math::setChild(parent, newEdge, Side_e::LEFT, rArena);
+    } else if (optChild != NULL_NODE) {
+      tree = splitArcNode(optChild, arcNode, nodesToClose, rArena, rCQueue);
+      auto parent = rArena[arcNode].parent;
+      auto childArcNode = math::createArcNode(e.children[0], rArena);
+      auto newEdge = splitArcNode(arcNode, childArcNode, nodesToClose, rArena, rCQueue);
+      math::setChild(parent, newEdge, Side_e::LEFT, rArena);
     } else {
       // case where site is the root
-      auto childArcNode = math::createArcNode(e.children[0]);
-      tree = splitArcNode(arcNode, childArcNode, nodesToClose, rCQueue);
+      auto childArcNode = math::createArcNode(e.children[0], rArena);
+      tree = splitArcNode(arcNode, childArcNode, nodesToClose, rArena, rCQueue);
     }
   }
   else
   {
-    if (optChild)
-      tree = ParaInsert(optChild, arcNode, nodesToClose, rCQueue);
+    if (optChild != NULL_NODE)
+      tree = ParaInsert(optChild, arcNode, nodesToClose, rArena, rCQueue);
     else
       tree = arcNode;
   }
 
- return {tree, nodesToClose};
+  auto last = before;
+  threadSubTree(tree, last, rArena);
+  rArena.link(last, after);
+
+  return {tree, nodesToClose};
 }
+
+} // namespace GVD_SCALAR_NS
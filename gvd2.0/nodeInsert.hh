@@ -1,18 +1,38 @@
 #ifndef NODE_INSERT_HH
 #define NODE_INSERT_HH
 
-#include <memory>
+#include "closeEventQueue.hh"
 #include "types.hh"
 
+namespace GVD_SCALAR_NS
+{
+
+// arcs needing a new close event after an insert, at most two
+// per split arc and two splits per insert
+typedef FixedVec<node_t, 4> closingNodes_t;
+
 struct SubTreeRslt
 {
-  std::shared_ptr<Node> root;
-  std::vector<std::shared_ptr<Node>> nodesToClose;
+  node_t root;
+  closingNodes_t nodesToClose;
 };
 
 SubTreeRslt generateSubTree(EventPacket const& e,
-                                      std::shared_ptr<Node> arcNode,
-                                      std::vector<CloseEvent>& rCQueue,
-                                      std::shared_ptr<Node> optChild = nullptr);
+                                      node_t arcNode,
+                                      NodeArena& rArena,
+                                      CloseEventQueue& rCQueue,
+                                      node_t optChild = NULL_NODE);
+
+// AVL balance a freshly generated subtree, returns its new root
+node_t balanceSubTree(node_t subRoot, NodeArena& rArena);
+
+// Restore the AVL balance and the arc counts from n up to the root
+// after a splice. Rotations preserve the in-order arc/edge sequence.
+void rebalance(node_t n, node_t& rRoot, NodeArena& rArena);
+
+// The arc at the in-order index of the beachline under root
+node_t arcAt(node_t root, uint32_t index, NodeArena const& arena);
+
+} // namespace GVD_SCALAR_NS
 
 #endif
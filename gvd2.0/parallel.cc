@@ -0,0 +1,151 @@
+#include "parallel.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  std::atomic<size_t> g_threadCount(0);
+}
+
+void setThreadCount(size_t count)
+{
+  g_threadCount = count;
+}
+
+size_t threadCount()
+{
+  size_t count = g_threadCount;
+  if (count == 0) count = std::thread::hardware_concurrency();
+  return std::max<size_t>(count, 1);
+}
+
+void parallelFor(size_t count, std::function<void(size_t)> const& f)
+{
+  auto threads = std::min(threadCount(), count);
+  if (threads <= 1)
+  {
+    for (size_t i = 0; i < count; ++i) f(i);
+    return;
+  }
+
+  // several chunks per thread so a slow chunk does not hold up the rest
+  auto chunk = std::max<size_t>(count / (threads * 8), 1);
+  std::atomic<size_t> next(0);
+  std::mutex errorMutex;
+  size_t errorIdx = std::numeric_limits<size_t>::max();
+  std::exception_ptr error;
+
+  auto work = [&]() {
+    for (;;)
+    {
+      auto start = next.fetch_add(chunk);
+      if (start >= count) return;
+      auto end = std::min(start + chunk, count);
+      for (auto i = start; i < end; ++i)
+      {
+        try
+        {
+          f(i);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (i < errorIdx)
+          {
+            errorIdx = i;
+            error = std::current_exception();
+          }
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+  work();
+  for (auto&& w : workers) w.join();
+
+  if (error) std::rethrow_exception(error);
+}
+
+uint64_t orderedBits(double v)
+{
+  v += 0.0; // -0.0 + 0.0 == 0.0
+  uint64_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  // negatives sort reversed, positives above them
+  return (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+namespace
+{
+  inline unsigned digit(SortKey const& k, unsigned pass)
+  {
+    return pass < 8 ? (k.lo >> (pass * 8)) & 0xff : (k.hi >> ((pass - 8) * 8)) & 0xff;
+  }
+}
+
+void radixSort(std::vector<SortKey>& rKeys)
+{
+  auto count = rKeys.size();
+  if (count < 2) return;
+
+  // blocks are fixed per pass so the scatter stays stable
+  auto blocks = std::max<size_t>(std::min(threadCount(), count / 4096), 1);
+  auto blockSize = (count + blocks - 1) / blocks;
+  typedef std::array<size_t, 256> histogram_t;
+  std::vector<histogram_t> histograms(blocks);
+  std::vector<SortKey> scratch(count);
+
+  auto* src = &rKeys;
+  auto* dst = &scratch;
+  for (unsigned pass = 0; pass < 16; ++pass)
+  {
+    parallelFor(blocks, [&](size_t b) {
+      auto& h = histograms[b];
+      h.fill(0);
+      auto end = std::min(count, (b + 1) * blockSize);
+      for (auto i = b * blockSize; i < end; ++i) ++h[digit((*src)[i], pass)];
+    });
+
+    // a digit shared by every key leaves the order as is
+    auto first = digit((*src)[0], pass);
+    size_t same = 0;
+    for (auto&& h : histograms) same += h[first];
+    if (same == count) continue;
+
+    // exclusive prefix over (digit, block), the start of each block's bucket
+    size_t offset = 0;
+    for (unsigned d = 0; d < 256; ++d)
+    {
+      for (auto&& h : histograms)
+      {
+        auto n = h[d];
+        h[d] = offset;
+        offset += n;
+      }
+    }
+
+    parallelFor(blocks, [&](size_t b) {
+      auto& h = histograms[b];
+      auto end = std::min(count, (b + 1) * blockSize);
+      for (auto i = b * blockSize; i < end; ++i)
+      {
+        auto const& k = (*src)[i];
+        (*dst)[h[digit(k, pass)]++] = k;
+      }
+    });
+    std::swap(src, dst);
+  }
+
+  if (src != &rKeys) rKeys.swap(scratch);
+}
@@ -0,0 +1,46 @@
+#ifndef PARALLEL_HH
+#define PARALLEL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+//------------------------------------------------------------
+// parallelFor
+// Runs f(i) for every i in [0, count) on threadCount() threads,
+// the calling thread included. Threads claim small chunks of
+// indices from a shared counter so uneven items balance out.
+// f may only write state owned by its index. The exception of
+// the lowest failing index is rethrown once all threads are done.
+//------------------------------------------------------------
+void parallelFor(size_t count, std::function<void(size_t)> const& f);
+
+//------------------------------------------------------------
+// SortKey
+// A 128 bit unsigned key, hi compared first, and the index of
+// the item it was made from.
+//------------------------------------------------------------
+struct SortKey
+{
+  uint64_t hi;
+  uint64_t lo;
+  uint32_t index;
+};
+
+// order preserving bits of v, -0.0 maps with 0.0
+uint64_t orderedBits(double v);
+
+//------------------------------------------------------------
+// radixSort
+// Stable LSD radix sort of rKeys by (hi, lo), one byte per pass
+// on threadCount() threads. Passes where every key has the same
+// byte are skipped, so narrow key ranges sort in fewer passes.
+//------------------------------------------------------------
+void radixSort(std::vector<SortKey>& rKeys);
+
+// threads used by parallelFor, 0 (the default) uses one per hardware thread
+void setThreadCount(size_t count);
+size_t threadCount();
+
+#endif
@@ -0,0 +1,279 @@
+#include "predicates.hh"
+
+namespace GVD_SCALAR_NS
+{
+
+namespace
+{
+  //------------------------------------------------------------
+  // Bounds
+  // Machine epsilon and splitter of decimal_t plus the error
+  // bounds of the orientation determinant, measured once the
+  // same way as Shewchuk's exactinit() so every scalar build
+  // gets its own constants.
+  //------------------------------------------------------------
+  struct Bounds
+  {
+    Bounds()
+    {
+      decimal_t half = 0.5;
+      decimal_t check = 1.0;
+      decimal_t lastCheck;
+      bool everyOther = true;
+      epsilon = 1.0;
+      splitter = 1.0;
+      do
+      {
+        lastCheck = check;
+        epsilon *= half;
+        if (everyOther) splitter *= 2.0;
+        everyOther = !everyOther;
+        check = 1.0 + epsilon;
+      } while (check != 1.0 && check != lastCheck);
+      splitter += 1.0;
+
+      resultErr = (3.0 + 8.0 * epsilon) * epsilon;
+      ccwErrA = (3.0 + 16.0 * epsilon) * epsilon;
+      ccwErrB = (2.0 + 12.0 * epsilon) * epsilon;
+      ccwErrC = (9.0 + 64.0 * epsilon) * epsilon * epsilon;
+    }
+
+    decimal_t epsilon;
+    decimal_t splitter;
+    decimal_t resultErr;
+    decimal_t ccwErrA;
+    decimal_t ccwErrB;
+    decimal_t ccwErrC;
+  };
+
+  Bounds const& bounds()
+  {
+    static const Bounds b;
+    return b;
+  }
+
+  // error free transformations, x + y (or x * y) == r + rTail exactly
+
+  inline void fastTwoSum(decimal_t a, decimal_t b, decimal_t& r, decimal_t& rTail)
+  {
+    r = a + b;
+    decimal_t bVirt = r - a;
+    rTail = b - bVirt;
+  }
+
+  inline void twoSum(decimal_t a, decimal_t b, decimal_t& r, decimal_t& rTail)
+  {
+    r = a + b;
+    decimal_t bVirt = r - a;
+    decimal_t aVirt = r - bVirt;
+    rTail = (a - aVirt) + (b - bVirt);
+  }
+
+  inline decimal_t twoDiffTail(decimal_t a, decimal_t b, decimal_t r)
+  {
+    decimal_t bVirt = a - r;
+    decimal_t aVirt = r + bVirt;
+    return (a - aVirt) + (bVirt - b);
+  }
+
+  inline void twoDiff(decimal_t a, decimal_t b, decimal_t& r, decimal_t& rTail)
+  {
+    r = a - b;
+    rTail = twoDiffTail(a, b, r);
+  }
+
+  inline void split(decimal_t a, decimal_t splitter, decimal_t& rHi, decimal_t& rLo)
+  {
+    decimal_t c = splitter * a;
+    decimal_t aBig = c - a;
+    rHi = c - aBig;
+    rLo = a - rHi;
+  }
+
+  inline void twoProduct(decimal_t a, decimal_t b, decimal_t& r, decimal_t& rTail)
+  {
+    auto const& s = bounds().splitter;
+    r = a * b;
+    decimal_t aHi, aLo, bHi, bLo;
+    split(a, s, aHi, aLo);
+    split(b, s, bHi, bLo);
+    decimal_t err1 = r - (aHi * bHi);
+    decimal_t err2 = err1 - (aLo * bHi);
+    decimal_t err3 = err2 - (aHi * bLo);
+    rTail = (aLo * bLo) - err3;
+  }
+
+  // (a1 + a0) - (b1 + b0) as a 4 component expansion, r[3] largest
+  inline void twoTwoDiff(decimal_t a1, decimal_t a0, decimal_t b1, decimal_t b0, decimal_t r[4])
+  {
+    decimal_t i, j, k, m;
+    twoDiff(a0, b0, i, r[0]);
+    twoSum(a1, i, j, k);
+    twoDiff(k, b1, m, r[1]);
+    twoSum(j, m, r[3], r[2]);
+  }
+
+  // sum of two nonoverlapping expansions without zero components,
+  // returns the length of r
+  size_t fastExpansionSum(size_t eLen, decimal_t const* e, size_t fLen, decimal_t const* f, decimal_t* r)
+  {
+    decimal_t q, qNew, h;
+    size_t ei = 0, fi = 0, ri = 0;
+    decimal_t eNow = e[0];
+    decimal_t fNow = f[0];
+    if ((fNow > eNow) == (fNow > -eNow))
+    {
+      q = eNow;
+      eNow = e[++ei];
+    }
+    else
+    {
+      q = fNow;
+      fNow = f[++fi];
+    }
+    if (ei < eLen && fi < fLen)
+    {
+      if ((fNow > eNow) == (fNow > -eNow))
+      {
+        fastTwoSum(eNow, q, qNew, h);
+        eNow = e[++ei];
+      }
+      else
+      {
+        fastTwoSum(fNow, q, qNew, h);
+        fNow = f[++fi];
+      }
+      q = qNew;
+      if (h != 0.0) r[ri++] = h;
+      while (ei < eLen && fi < fLen)
+      {
+        if ((fNow > eNow) == (fNow > -eNow))
+        {
+          twoSum(q, eNow, qNew, h);
+          eNow = e[++ei];
+        }
+        else
+        {
+          twoSum(q, fNow, qNew, h);
+          fNow = f[++fi];
+        }
+        q = qNew;
+        if (h != 0.0) r[ri++] = h;
+      }
+    }
+    while (ei < eLen)
+    {
+      twoSum(q, eNow, qNew, h);
+      eNow = e[++ei];
+      q = qNew;
+      if (h != 0.0) r[ri++] = h;
+    }
+    while (fi < fLen)
+    {
+      twoSum(q, fNow, qNew, h);
+      fNow = f[++fi];
+      q = qNew;
+      if (h != 0.0) r[ri++] = h;
+    }
+    if (q != 0.0 || ri == 0) r[ri++] = q;
+    return ri;
+  }
+
+  decimal_t estimate(size_t len, decimal_t const* e)
+  {
+    decimal_t q = e[0];
+    for (size_t i = 1; i < len; ++i) q += e[i];
+    return q;
+  }
+
+  // exact tail of the determinant, called once the fast
+  // determinant can not be trusted
+  decimal_t orient2dAdapt(vec2 const& a, vec2 const& b, vec2 const& c, decimal_t detSum)
+  {
+    auto const& bnd = bounds();
+    decimal_t acx = a.x - c.x;
+    decimal_t bcx = b.x - c.x;
+    decimal_t acy = a.y - c.y;
+    decimal_t bcy = b.y - c.y;
+
+    decimal_t detLeft, detLeftTail, detRight, detRightTail;
+    twoProduct(acx, bcy, detLeft, detLeftTail);
+    twoProduct(acy, bcx, detRight, detRightTail);
+
+    // the expansions below read one past their length, see fastExpansionSum
+    decimal_t B[5] = {0.0};
+    twoTwoDiff(detLeft, detLeftTail, detRight, detRightTail, B);
+
+    auto det = estimate(4, B);
+    auto errBound = bnd.ccwErrB * detSum;
+    if (det >= errBound || -det >= errBound) return det;
+
+    auto acxTail = twoDiffTail(a.x, c.x, acx);
+    auto bcxTail = twoDiffTail(b.x, c.x, bcx);
+    auto acyTail = twoDiffTail(a.y, c.y, acy);
+    auto bcyTail = twoDiffTail(b.y, c.y, bcy);
+
+    if (acxTail == 0.0 && acyTail == 0.0 && bcxTail == 0.0 && bcyTail == 0.0)
+      return det;
+
+    errBound = bnd.ccwErrC * detSum + bnd.resultErr * math::abs(det);
+    det += (acx * bcyTail + bcy * acxTail) - (acy * bcxTail + bcx * acyTail);
+    if (det >= errBound || -det >= errBound) return det;
+
+    decimal_t s1, s0, t1, t0;
+    decimal_t u[5] = {0.0};
+    decimal_t C1[9] = {0.0};
+    decimal_t C2[13] = {0.0};
+    decimal_t D[17] = {0.0};
+
+    twoProduct(acxTail, bcy, s1, s0);
+    twoProduct(acyTail, bcx, t1, t0);
+    twoTwoDiff(s1, s0, t1, t0, u);
+    auto c1Len = fastExpansionSum(4, B, 4, u, C1);
+
+    twoProduct(acx, bcyTail, s1, s0);
+    twoProduct(acy, bcxTail, t1, t0);
+    twoTwoDiff(s1, s0, t1, t0, u);
+    auto c2Len = fastExpansionSum(c1Len, C1, 4, u, C2);
+
+    twoProduct(acxTail, bcyTail, s1, s0);
+    twoProduct(acyTail, bcxTail, t1, t0);
+    twoTwoDiff(s1, s0, t1, t0, u);
+    auto dLen = fastExpansionSum(c2Len, C2, 4, u, D);
+
+    return D[dLen - 1];
+  }
+}
+
+namespace math
+{
+  decimal_t orient2d(vec2 const& a, vec2 const& b, vec2 const& c)
+  {
+    decimal_t detLeft = (a.x - c.x) * (b.y - c.y);
+    decimal_t detRight = (a.y - c.y) * (b.x - c.x);
+    decimal_t det = detLeft - detRight;
+    decimal_t detSum;
+
+    if (detLeft > 0.0)
+    {
+      if (detRight <= 0.0) return det;
+      detSum = detLeft + detRight;
+    }
+    else if (detLeft < 0.0)
+    {
+      if (detRight >= 0.0) return det;
+      detSum = -detLeft - detRight;
+    }
+    else
+    {
+      return det;
+    }
+
+    auto errBound = bounds().ccwErrA * detSum;
+    if (det >= errBound || -det >= errBound) return det;
+
+    return orient2dAdapt(a, b, c, detSum);
+  }
+}
+
+} // namespace GVD_SCALAR_NS
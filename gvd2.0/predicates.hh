@@ -0,0 +1,26 @@
+#ifndef PREDICATES_HH
+#define PREDICATES_HH
+
+#include "types.hh"
+
+namespace GVD_SCALAR_NS
+{
+
+namespace math
+{
+  //------------------------------------------------------------
+  // orient2d
+  // Twice the signed area of the triangle a, b, c - positive
+  // when c is left of the line a->b. The sign is exact for any
+  // decimal_t input: the plain floating point determinant is
+  // used when its error bound allows, near degenerate inputs
+  // fall back to expansion arithmetic (Shewchuk's adaptive
+  // predicates). Relies on round to nearest without fused
+  // multiply-add, the default with -std=c++17.
+  //------------------------------------------------------------
+  decimal_t orient2d(vec2 const& a, vec2 const& b, vec2 const& c);
+}
+
+} // namespace GVD_SCALAR_NS
+
+#endif
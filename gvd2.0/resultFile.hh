@@ -0,0 +1,60 @@
+#ifndef RESULT_FILE_HH
+#define RESULT_FILE_HH
+
+#include <cstdint>
+#include <vector>
+
+//------------------------------------------------------------
+// Binary result file, see writeBinaryResults. Native byte order:
+// ResultHeader
+// ResultSection sections[sectionCount]
+// per section, at the positions its ResultSection gives:
+//   uint64_t offsets[itemCount + 1] - first point of each item
+//   double values[stride * pointCount] - the points, x y (yval)
+// Every part is 8 byte aligned so a mapped file is read in place.
+//------------------------------------------------------------
+const char g_resultMagic[8] = {'G', 'V', 'D', 'R', 'S', 'L', 'T', '1'};
+const uint32_t RESULT_VERSION = 1;
+
+enum class ResultSection_e : uint32_t
+{
+  POLYGONS = 1, // sites, without the closing point
+  EDGES = 2, // straight edges, two points each
+  CURVED_EDGES = 3,
+  BEACHLINE_EDGES = 4,
+  BEACHLINE_CURVED_EDGES = 5,
+  CLOSE_EVENTS = 6 // one x y yval point each
+};
+
+struct ResultHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t sectionCount;
+};
+
+struct ResultSection
+{
+  ResultSection_e type;
+  uint32_t stride; // values per point
+  uint64_t itemCount;
+  uint64_t pointCount;
+  uint64_t offsetsPos; // bytes from the start of the file
+  uint64_t valuesPos;
+};
+
+//------------------------------------------------------------
+// ResultArrays
+// One section in memory, item i has the points offsets[i] up to
+// offsets[i + 1] of values. This is what writeBinaryResults puts
+// in the file and what the addon hands to JS without a copy.
+//------------------------------------------------------------
+struct ResultArrays
+{
+  ResultSection_e type;
+  uint32_t stride;
+  std::vector<uint32_t> offsets;
+  std::vector<double> values;
+};
+
+#endif
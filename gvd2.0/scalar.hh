@@ -0,0 +1,103 @@
+#ifndef SCALAR_HH
+#define SCALAR_HH
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+//------------------------------------------------------------
+// Scalar type of the engine
+// Selected at compile time with GVD_SCALAR, see Scalar_e.
+// The engine is declared in GVD_SCALAR_NS so objects built
+// with different scalars link into one binary, sweepEngine.hh
+// is the scalar independent entry point.
+//------------------------------------------------------------
+enum class Scalar_e
+{
+  DOUBLE = 1,
+  LONG_DOUBLE = 2,
+  FLOAT128 = 3
+};
+
+#ifndef GVD_SCALAR
+#define GVD_SCALAR 2
+#endif
+
+#if GVD_SCALAR == 1
+#define GVD_SCALAR_NS gvd_double
+#elif GVD_SCALAR == 2
+#define GVD_SCALAR_NS gvd_long_double
+#elif GVD_SCALAR == 3
+#define GVD_SCALAR_NS gvd_float128
+#include <cstdio>
+#include <quadmath.h>
+#else
+#error "GVD_SCALAR must be 1 (double), 2 (long double) or 3 (__float128)"
+#endif
+
+namespace GVD_SCALAR_NS
+{
+
+#if GVD_SCALAR == 1
+typedef double decimal_t;
+#elif GVD_SCALAR == 2
+typedef long double decimal_t;
+#else
+typedef __float128 decimal_t;
+#endif
+
+static const Scalar_e g_scalar = static_cast<Scalar_e>(GVD_SCALAR);
+
+namespace math
+{
+  // math functions of decimal_t, the std overloads do not cover __float128
+  using std::abs;
+  using std::acos;
+  using std::atan2;
+  using std::cos;
+  using std::sin;
+  using std::sqrt;
+
+#if GVD_SCALAR == 3
+  inline decimal_t abs(decimal_t v) { return fabsq(v); }
+  inline decimal_t acos(decimal_t v) { return acosq(v); }
+  inline decimal_t atan2(decimal_t y, decimal_t x) { return atan2q(y, x); }
+  inline decimal_t cos(decimal_t v) { return cosq(v); }
+  inline decimal_t sin(decimal_t v) { return sinq(v); }
+  inline decimal_t sqrt(decimal_t v) { return sqrtq(v); }
+
+  inline decimal_t epsilon() { return 0x1p-112L; } // FLT128_EPSILON needs the Q literal suffix
+  inline int digits10() { return FLT128_DIG; }
+#else
+  inline decimal_t epsilon() { return std::numeric_limits<decimal_t>::epsilon(); }
+  inline int digits10() { return std::numeric_limits<decimal_t>::digits10; }
+#endif
+
+  // v as printf %.*g into [first, last), returns the end of the text
+  inline char* toChars(char* first, char* last, decimal_t v, int precision)
+  {
+#if GVD_SCALAR == 3
+    auto n = quadmath_snprintf(first, static_cast<size_t>(last - first), "%.*Qg", precision, v);
+    return n < 0 || n >= last - first ? first : first + n;
+#else
+    auto r = std::to_chars(first, last, v, std::chars_format::general, precision);
+    return r.ec == std::errc() ? r.ptr : first;
+#endif
+  }
+}
+
+#if GVD_SCALAR == 3
+// iostreams have no __float128 overload, print with the stream precision
+inline std::ostream& operator<<(std::ostream& os, decimal_t v)
+{
+  char buf[64];
+  auto precision = os.precision() > 0 ? static_cast<int>(os.precision()) : 6;
+  quadmath_snprintf(buf, sizeof(buf), "%.*Qg", precision, v);
+  return os << buf;
+}
+#endif
+
+} // namespace GVD_SCALAR_NS
+
+#endif
@@ -0,0 +1,28 @@
+#include <iostream>
+#include <string>
+
+#include "dataset.hh"
+
+// packs a dataset file list into a binary scene, see convertToScene
+int main(int argc, char** argv)
+{
+  // all paths in the file list are relative to the gvd-fortune/ folder
+  if (argc < 3)
+  {
+    std::cout << "Usage: <program> <input file containing a list of file paths> <output scene file>\n";
+    return 0;
+  }
+
+  try
+  {
+    auto count = GVD_SCALAR_NS::convertToScene(argv[1], argv[2]);
+    std::cout << "Wrote " << count << " polygons to " << argv[2] << std::endl;
+  }
+  catch(const std::exception& e)
+  {
+    std::cout << e.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
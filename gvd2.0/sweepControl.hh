@@ -0,0 +1,23 @@
+#ifndef SWEEP_CONTROL_HH
+#define SWEEP_CONTROL_HH
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+//------------------------------------------------------------
+// SweepControl
+// Lets another thread stop an advance and follow it. The sweep
+// looks at it every interval events, reports progress and stops
+// between two events once cancelled, so the sweep is left ready
+// to continue from where it got to.
+//------------------------------------------------------------
+struct SweepControl
+{
+  std::atomic<bool> cancelled{false};
+  size_t interval = 1024;
+  // events processed and the y of the last one, on the sweep thread
+  std::function<void(size_t, double)> progress;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "sweepEngine.hh"
+
+#include "crossings.hh"
+#include "dataset.hh"
+#include "fortune.hh"
+#include "utils.hh"
+
+namespace GVD_SCALAR_NS
+{
+
+namespace
+{
+  class ScalarSweepEngine : public SweepEngine
+  {
+  public:
+    ScalarSweepEngine()
+      : m_polygons(), m_cancelMode(CancelMode_e::EAGER), m_checkpointInterval(256),
+      m_sweep(), m_result()
+    {}
+
+    Scalar_e scalar() const override { return g_scalar; }
+
+    size_t load(std::string const& inputFiles, CancelMode_e cancelMode, size_t checkpointInterval) override
+    {
+      size_t vertexCount;
+      m_polygons = processInputFiles(inputFiles, vertexCount);
+      m_cancelMode = cancelMode;
+      m_checkpointInterval = checkpointInterval;
+      m_sweep.reset();
+      m_result = ComputeResult();
+      return vertexCount;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> findCrossings(bool repair) override
+    {
+      auto rslt = GVD_SCALAR_NS::findCrossings(m_polygons, repair);
+      if (repair && !rslt.empty())
+      {
+        m_sweep.reset();
+        m_result = ComputeResult();
+      }
+      return rslt;
+    }
+
+    bool advance(double sweepline, std::string& rMsg, std::string& rErr, SweepControl const* pControl) override
+    {
+      if (!m_sweep)
+        m_sweep.reset(new SweepState(createDataQueue(m_polygons), m_cancelMode, m_checkpointInterval));
+      auto rslt = m_sweep->advance(sweepline, rMsg, rErr, pControl);
+      if (m_sweep->cancelled())
+        return false;
+      m_result = std::move(rslt);
+      m_result.polygons = m_polygons;
+      return true;
+    }
+
+    void writeResults(std::string const& pPath, std::string const& ePath,
+                      std::string const& bPath, std::string const& cPath) const override
+    {
+      GVD_SCALAR_NS::writeResults(m_result, pPath, ePath, bPath, cPath);
+    }
+
+    void writeBinaryResults(std::string const& path) const override
+    {
+      GVD_SCALAR_NS::writeBinaryResults(m_result, path);
+    }
+
+    std::vector<ResultArrays> resultArrays() const override
+    {
+      return GVD_SCALAR_NS::resultArrays(m_result);
+    }
+
+  private:
+    std::vector<Polygon> m_polygons;
+    CancelMode_e m_cancelMode;
+    size_t m_checkpointInterval;
+    std::unique_ptr<SweepState> m_sweep;
+    ComputeResult m_result;
+  };
+}
+
+std::unique_ptr<SweepEngine> createSweepEngine()
+{
+  return std::unique_ptr<SweepEngine>(new ScalarSweepEngine());
+}
+
+} // namespace GVD_SCALAR_NS
@@ -0,0 +1,66 @@
+#ifndef SWEEP_ENGINE_HH
+#define SWEEP_ENGINE_HH
+
+#include "closeEventQueue.hh"
+#include "resultFile.hh"
+#include "scalar.hh"
+#include "sweepControl.hh"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+//------------------------------------------------------------
+// SweepEngine
+// Scalar independent handle on the sweep of a dataset. Every
+// GVD_SCALAR build of the engine provides one and
+// createSweepEngine picks it at run time, so the CLI and the
+// addon can run the scalar variants side by side.
+//------------------------------------------------------------
+class SweepEngine
+{
+public:
+  virtual ~SweepEngine() {}
+
+  virtual Scalar_e scalar() const = 0;
+
+  // read the dataset file list, the sweep restarts on the next advance.
+  // Returns the number of vertices read.
+  virtual size_t load(std::string const& inputFiles, CancelMode_e cancelMode = CancelMode_e::EAGER,
+                    size_t checkpointInterval = 256) = 0;
+
+  // label pairs of loaded polygons whose segments cross, see
+  // findCrossings. repair drops the second polygon of each pair
+  // and restarts the sweep.
+  virtual std::vector<std::pair<uint32_t, uint32_t>> findCrossings(bool repair) = 0;
+
+  // continue the sweep to the sweepline, see SweepState::advance.
+  // Returns false if the control cancelled it, the results of the
+  // last finished advance are kept then.
+  virtual bool advance(double sweepline, std::string& rMsg, std::string& rErr,
+                       SweepControl const* pControl = nullptr) = 0;
+
+  // results of the last advance with polygon, edge, beachline and close event paths
+  virtual void writeResults(std::string const& pPath, std::string const& ePath,
+                            std::string const& bPath, std::string const& cPath) const = 0;
+
+  // the same results in one binary file, see resultFile.hh
+  virtual void writeBinaryResults(std::string const& path) const = 0;
+
+  // the same results as arrays, see ResultArrays
+  virtual std::vector<ResultArrays> resultArrays() const = 0;
+};
+
+std::unique_ptr<SweepEngine> createSweepEngine(Scalar_e scalar = Scalar_e::LONG_DOUBLE);
+
+// "double", "long-double" or "float128"
+Scalar_e scalarFromString(std::string const& name);
+
+// provided by each scalar build
+namespace gvd_double { std::unique_ptr<SweepEngine> createSweepEngine(); }
+namespace gvd_long_double { std::unique_ptr<SweepEngine> createSweepEngine(); }
+namespace gvd_float128 { std::unique_ptr<SweepEngine> createSweepEngine(); }
+
+#endif
@@ -0,0 +1,25 @@
+#include "sweepEngine.hh"
+
+#include <stdexcept>
+
+std::unique_ptr<SweepEngine> createSweepEngine(Scalar_e scalar)
+{
+  switch (scalar)
+  {
+    case Scalar_e::DOUBLE:
+      return gvd_double::createSweepEngine();
+    case Scalar_e::LONG_DOUBLE:
+      return gvd_long_double::createSweepEngine();
+    case Scalar_e::FLOAT128:
+      return gvd_float128::createSweepEngine();
+  }
+  throw std::runtime_error("Invalid scalar type");
+}
+
+Scalar_e scalarFromString(std::string const& name)
+{
+  if (name == "double") return Scalar_e::DOUBLE;
+  if (name == "long-double") return Scalar_e::LONG_DOUBLE;
+  if (name == "float128") return Scalar_e::FLOAT128;
+  throw std::runtime_error("Unknown scalar type: " + name);
+}
@@ -3,11 +3,18 @@
 #include <fstream>
 #include <chrono>
 
+#include "closeEventQueue.hh"
+#include "crossings.hh"
 #include "dataset.hh"
+#include "fortune.hh"
 #include "types.hh"
 #include "utils.hh"
+#include "marchingSquares.hh"
 #include "math.hh"
+#include "parallel.hh"
+#include "sweepEngine.hh"
 
+using namespace GVD_SCALAR_NS;
 
 namespace
 {
@@ -17,6 +24,34 @@ namespace
   //   rQueue.push_back(e);
   //   std::sort(rQueue.begin(), rQueue.end(), math::event_less_than());
   // }
+
+  bool samePoints(std::vector<vec2> const& a, std::vector<vec2> const& b)
+  {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), math::equiv2);
+  }
+
+  bool sameCurves(std::vector<std::vector<vec2>> const& a, std::vector<std::vector<vec2>> const& b)
+  {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), samePoints);
+  }
+
+  // same edges, beachline and pending close events
+  bool sameResult(ComputeResult const& a, ComputeResult const& b)
+  {
+    return a.edges.size() == b.edges.size()
+      && std::equal(a.edges.begin(), a.edges.end(), b.edges.begin(),
+                    [](std::pair<vec2, vec2> const& l, std::pair<vec2, vec2> const& r) {
+                      return math::equiv2(l.first, r.first) && math::equiv2(l.second, r.second);
+                    })
+      && sameCurves(a.curvedEdges, b.curvedEdges)
+      && sameCurves(a.b_edges, b.b_edges)
+      && sameCurves(a.b_curvedEdges, b.b_curvedEdges)
+      && a.b_closeEvents.size() == b.b_closeEvents.size()
+      && std::equal(a.b_closeEvents.begin(), a.b_closeEvents.end(), b.b_closeEvents.begin(),
+                    [](CloseEvent const& l, CloseEvent const& r) {
+                      return l.yval == r.yval && math::equiv2(l.point, r.point);
+                    });
+  }
 }
 
 int main(int /* argc */, char** /* argv */)
@@ -58,6 +93,14 @@ int main(int /* argc */, char** /* argv */)
     if (math::equiv2(e1, e2))
       throw std::runtime_error("Failed equal test");
 
+    // one epsilon off the line is lost by the plain determinant
+    vec2 o1(12.0, 12.0);
+    vec2 o2(24.0, 24.0);
+    if (math::orient2d(o1, o2, vec2(0.5, 0.5)) != 0
+        || !(math::orient2d(o1, o2, vec2(0.5 + math::epsilon(), 0.5)) < 0)
+        || !(math::orient2d(vec2(0.5, 0.5 + math::epsilon()), o1, o2) > 0))
+      throw std::runtime_error("Failed exact orientation test");
+
     vec2 a1(0.0, 0.623);
     vec2 a2(0.0, 0.123);
     vec2 a3(0.0, 0.723); // colinear - not right
@@ -72,18 +115,272 @@ int main(int /* argc */, char** /* argv */)
     if (!math::isRightOfLine(a1, a2, a5))
       throw std::runtime_error("Failed right of line test3");
 
+    auto segV = math::createSegmentV(vec2(0.0, 0.0), vec2(1.0, 1.0));
+    V diag(vec2(0.0, 0.0), vec2(1.0, 1.0), segV, 0.25, 0);
+    if (!math::equiv2(diag.point, vec2(0.25, 0.25))
+        || std::abs(math::length(diag.vectors[0]) - 1.0) > 1e-12
+        || std::abs(math::crossProduct(diag.vectors[1], vec2(1.0, 1.0))) < 1e-6)
+      throw std::runtime_error("Failed segment V constants");
+
+    auto cross = math::intersectLines(vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0), vec2(1.0, -1.0));
+    if (!cross || !math::equiv2(*cross, vec2(0.0, 0.0))
+        || math::intersectLines(vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0)))
+      throw std::runtime_error("Failed line intersection");
+
+    // ids 1 and 23 used to share a key with 12 and 3
+    Event b1(EventType_e::POINT, 0, vec2(0.0, 0.0));
+    Event b2(EventType_e::POINT, 0, vec2(1.0, 0.0));
+    Event b3(EventType_e::POINT, 0, vec2(0.0, 1.0));
+    Event b4(EventType_e::POINT, 0, vec2(-1.0, 0.0));
+    b1.id = 1; b2.id = 23; b3.id = 12; b4.id = 3;
+    math::BisectorCache bisectors;
+    uint32_t slot = std::numeric_limits<uint32_t>::max();
+    auto const& cached = bisectors.get(b1, b2, slot);
+    if (&bisectors.get(b1, b2) != &cached || &bisectors.get(b1, b2, slot) != &cached
+        || &bisectors.get(b3, b4) == &cached || bisectors.size() != 2)
+      throw std::runtime_error("Failed bisector cache");
+
+    auto roots = math::quadratic(1.0, 0.0, -1.0);
+    bool overflow = false;
+    try { roots.push_back(0.0); }
+    catch (std::runtime_error const&) { overflow = true; }
+    if (roots.size() != 2 || !overflow)
+      throw std::runtime_error("Failed fixed capacity roots");
+
+    for (auto&& scalar : {Scalar_e::DOUBLE, Scalar_e::LONG_DOUBLE, Scalar_e::FLOAT128})
+    {
+      if (createSweepEngine(scalar)->scalar() != scalar)
+        throw std::runtime_error("Failed scalar engine selection");
+    }
+
+    // every index runs once and the lowest failure is reported
+    setThreadCount(4);
+    std::vector<size_t> squares(1000);
+    std::string failed;
+    try
+    {
+      parallelFor(squares.size(), [&squares](size_t i) {
+        squares[i] = i * i;
+        if (i == 700 || i == 900) throw std::runtime_error(std::to_string(i));
+      });
+    }
+    catch (std::runtime_error const& e) { failed = e.what(); }
+    if (failed != "700" || squares[999] != 999 * 999 || squares[1] != 1)
+      throw std::runtime_error("Failed parallel for");
+
+    // keys spread over several blocks sort stably, signs included
+    std::vector<SortKey> keys(20000);
+    for (uint32_t i = 0; i < keys.size(); ++i)
+      keys[i] = {orderedBits((i * 7919 % 1000) - 500.5), orderedBits(i % 3 ? -0.0 : 0.0), i};
+    auto expected = keys;
+    std::stable_sort(expected.begin(), expected.end(), [](SortKey const& a, SortKey const& b) {
+      return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+    });
+    radixSort(keys);
+    setThreadCount(0);
+    if (orderedBits(-1.0) >= orderedBits(-0.5) || orderedBits(-0.5) >= orderedBits(0.0)
+        || orderedBits(0.0) >= orderedBits(2.0)
+        || !std::equal(keys.begin(), keys.end(), expected.begin(), [](SortKey const& a, SortKey const& b) {
+             return a.index == b.index;
+           }))
+      throw std::runtime_error("Failed radix sort");
+
+    // y values that differ below double precision still order by y
+    Polygon lowered;
+    lowered.addPoint(vec2(0.3, decimal_t(0.5) - 1e-6));
+    Polygon input;
+    input.addPoint(vec2(0.1, 0.499999));
+    auto nearQueue = createDataQueue({input, lowered});
+    if (nearQueue.size() != 2 || math::event_less_than()(nearQueue[1], nearQueue[0]))
+      throw std::runtime_error("Failed to sort sites closer than double precision");
+
+    // a ring with a hole and a cell touching its corner
+    std::vector<uint8_t> grid = {1, 1, 1, 0,
+                                 1, 0, 1, 0,
+                                 1, 1, 1, 0,
+                                 0, 0, 0, 1};
+    auto contours = traceContours(grid, 4, 4);
+    if (contours.size() != 3 || contours[0].size() != 4 || contours[1].size() != 4 || contours[2].size() != 4
+        || std::none_of(contours[0].begin(), contours[0].end(), [](GridPoint const& p) { return p.x == 2.95 && p.y == 2.95; })
+        || std::none_of(contours[2].begin(), contours[2].end(), [](GridPoint const& p) { return p.x == 3.05 && p.y == 3.05; }))
+      throw std::runtime_error("Failed to trace contours");
+
+    // overlapping boxes are reported and the later one dropped
+    std::vector<Polygon> boxes;
+    for (auto&& corner : {vec2(0.0, 0.0), vec2(0.1, 0.1), vec2(0.5, 0.5)})
+    {
+      boxes.push_back(Polygon());
+      boxes.back().addPoint(corner);
+      boxes.back().addPoint(vec2(corner.x + 0.2, corner.y));
+      boxes.back().addPoint(vec2(corner.x + 0.2, corner.y + 0.2));
+      boxes.back().addPoint(vec2(corner.x, corner.y + 0.2));
+    }
+    auto crossings = findCrossings(boxes, true);
+    if (crossings.size() != 1 || crossings[0].first != boxes[0].getLabel()
+        || boxes.size() != 2 || !findCrossings(boxes).empty())
+      throw std::runtime_error("Failed to find crossings");
+
     Polygon poly;
     poly.addPoint(vec2(0.7, 0.5));
     poly.addPoint(vec2(0.4, 0.4));
     poly.addPoint(vec2(0.4, 0.3));
     auto queue = createDataQueue({poly});
-    if (queue.back().type != EventType_e::POINT)
+    // each vertex comes after the segments hanging below it, left to right
+    if (queue.size() != 6 || queue.back().type != EventType_e::POINT
+        || queue[3].type != EventType_e::SEG || queue[4].type != EventType_e::SEG
+        || !math::equiv2(queue[3].b, vec2(0.4, 0.4)) || !math::equiv2(queue[4].b, vec2(0.4, 0.3))
+        || queue[1].type != EventType_e::SEG || !math::equiv2(queue[1].a, vec2(0.4, 0.4)))
       throw std::runtime_error("Failed to create queue");
 
-    auto c1 = newCloseEvent(0.6, nullptr, vec2(0.0, 0.0));
-    auto c2 = newCloseEvent(0.3999, nullptr, vec2(0.0, 0.0));
+    Polygon pt1;
+    pt1.addPoint(vec2(-0.3, 0.1));
+    Polygon pt2;
+    pt2.addPoint(vec2(0.2, -0.2));
+    auto sweepQueue = createDataQueue({poly, pt1, pt2});
+    SweepState sweep(sweepQueue, CancelMode_e::EAGER, 2);
+    std::string msg, err;
+    sweep.advance(-0.8, msg, err);
+    auto restored = sweep.advance(0.35, msg, err);
+    auto fresh = fortune(sweepQueue, 0.35, msg, err);
+    auto resumed = sweep.advance(0.1, msg, err);
+    auto restoredAgain = sweep.advance(0.3, msg, err);
+    if (!err.empty() || !sameResult(restored, fresh)
+        || !sameResult(resumed, fortune(sweepQueue, 0.1, msg, err))
+        || !sameResult(restoredAgain, fortune(sweepQueue, 0.3, msg, err)))
+      throw std::runtime_error("Failed to restore sweep state");
+
+    // a grid of sites keeps the beachline short so later checkpoints
+    // are taken and restored
+    std::vector<Polygon> sites(400);
+    for (size_t i = 0; i < sites.size(); ++i)
+      sites[i].addPoint(vec2(-0.9 + (i % 20) * 0.09 + (i * 7919 % 101) * 1e-4,
+                            0.9 - (i / 20) * 0.09 + (i * 104729 % 97) * 1e-4));
+    auto gridQueue = createDataQueue(sites);
+    SweepState gridSweep(gridQueue, CancelMode_e::EAGER, 16);
+    gridSweep.advance(-1.0, msg, err);
+    auto gridRestored = gridSweep.advance(-0.4, msg, err);
+    if (!err.empty() || gridRestored.edges.empty() || !sameResult(gridRestored, fortune(gridQueue, -0.4, msg, err)))
+      throw std::runtime_error("Failed to restore grid sweep state");
+
+    // the binary results hold every edge and close event
+    std::string resultPath = "./test_results.bin";
+    fresh.polygons = {poly, pt1, pt2};
+    writeBinaryResults(fresh, resultPath);
+    std::ifstream resultFile(resultPath.c_str(), std::ifstream::binary);
+    std::string bytes((std::istreambuf_iterator<char>(resultFile)), std::istreambuf_iterator<char>());
+    std::remove(resultPath.c_str());
+    auto const* header = reinterpret_cast<ResultHeader const*>(bytes.data());
+    auto const* sections = reinterpret_cast<ResultSection const*>(bytes.data() + sizeof(ResultHeader));
+    if (bytes.size() < sizeof(ResultHeader) + 6 * sizeof(ResultSection) || header->version != RESULT_VERSION
+        || header->sectionCount != 6 || sections[0].itemCount != 3 || sections[0].pointCount != 5
+        || sections[1].itemCount != fresh.edges.size() || sections[5].itemCount != fresh.b_closeEvents.size()
+        || sections[5].valuesPos + sections[5].pointCount * 3 * sizeof(double) != bytes.size()
+        || reinterpret_cast<double const*>(bytes.data() + sections[0].valuesPos)[0] != 0.7)
+      throw std::runtime_error("Failed to write binary results");
+
+    // a scene holds the same polygons as the files it was made from
+    std::vector<std::string> scenePaths = {"./test_scene_0.txt", "./test_scene_1.txt", "./test_scene_list.txt",
+                                           "./test_scene.bin"};
+    {
+      std::ofstream(scenePaths[0].c_str()) << "0.1 0.2\n0.5 0.25\n0.3 0.6\n0.1 0.2\n";
+      std::ofstream(scenePaths[1].c_str()) << "-0.4 -0.3\n-0.4 -0.3\n";
+      std::ofstream(scenePaths[2].c_str()) << scenePaths[0] << "\n" << scenePaths[1] << "\n";
+    }
+    convertToScene(scenePaths[2], scenePaths[3]);
+    auto fromFiles = processInputFiles(scenePaths[2]);
+    auto fromScene = processInputFiles(scenePaths[3]);
+    auto sameScene = fromFiles.size() == fromScene.size();
+    for (size_t i = 0; sameScene && i < fromFiles.size(); ++i)
+    {
+      auto const& f = fromFiles[i].orderedPointSites;
+      auto const& s = fromScene[i].orderedPointSites;
+      sameScene = f.size() == s.size();
+      for (size_t k = 0; sameScene && k < f.size(); ++k)
+        sameScene = f[k].point.x == s[k].point.x && f[k].point.y == s[k].point.y;
+    }
+    // a vertex count that wraps the size check is still rejected
+    {
+      std::fstream scene(scenePaths[3].c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+      uint64_t vertexCount = uint64_t(1) << 63;
+      scene.seekp(16);
+      scene.write(reinterpret_cast<char const*>(&vertexCount), sizeof(vertexCount));
+    }
+    auto corruptRejected = false;
+    try
+    {
+      processInputFiles(scenePaths[3]);
+    }
+    catch (std::runtime_error const&)
+    {
+      corruptRejected = true;
+    }
+    for (auto&& p : scenePaths) std::remove(p.c_str());
+    if (!sameScene || fromFiles.size() != 2 || !corruptRejected)
+      throw std::runtime_error("Failed scene round trip");
+
+    // a map is turned about its corner in grid cells and then scaled,
+    // as dataset.js does with the canvas pixels
+    std::string mapPath = "./test_grid.map";
+    std::ofstream(mapPath.c_str()) << "type octile\nheight 4\nwidth 4\nmap\n....\n.@..\n....\n....\n";
+    auto mapPolygons = processInputFiles(mapPath);
+    std::remove(mapPath.c_str());
+    // the blocked cell's corner at column 2, row 2
+    double theta = -0.02;
+    vec2 corner(2.0 * (2.0 * std::cos(theta) - 2.0 * std::sin(theta)) / 4.0 - 1.0,
+                1.0 - 2.0 * (2.0 * std::sin(theta) + 2.0 * std::cos(theta)) / 4.0);
+    if (mapPolygons.size() != 1 || mapPolygons[0].orderedPointSites.size() != 4
+        || std::none_of(mapPolygons[0].orderedPointSites.begin(), mapPolygons[0].orderedPointSites.end(),
+                        [&corner](Event const& e) { return math::equiv2(e.point, corner); }))
+      throw std::runtime_error("Failed map rotation");
+
+    // sites along a diagonal grow the beachline at one end
+    std::vector<Polygon> stairs(64);
+    for (size_t i = 0; i < stairs.size(); ++i)
+      stairs[i].addPoint(vec2(-0.9 + i * 0.028, 0.9 - i * 0.028));
+    SweepState stairSweep(createDataQueue(stairs), CancelMode_e::EAGER, 0);
+    stairSweep.advance(-0.95, msg, err);
+    size_t maxDepth;
+    double avgDepth;
+    stairSweep.beachlineDepth(maxDepth, avgDepth);
+    if (!err.empty() || maxDepth == 0 || maxDepth > 12)
+      throw std::runtime_error("Failed beachline balance with depth " + std::to_string(maxDepth));
+
+    // a cancelled advance stops at the interval and the next one goes on
+    SweepControl control;
+    control.interval = 16;
+    size_t reported = 0;
+    control.progress = [&control, &reported](size_t events, double) {
+      reported = events;
+      control.cancelled = true;
+    };
+    SweepState cancelSweep(createDataQueue(stairs), CancelMode_e::EAGER, 0);
+    cancelSweep.advance(-0.95, msg, err, &control);
+    if (!cancelSweep.cancelled() || reported != 16 || cancelSweep.eventCount() != 16)
+      throw std::runtime_error("Failed to cancel sweep");
+    auto finished = cancelSweep.advance(-0.95, msg, err);
+    auto uncancelled = stairSweep.advance(-0.95, msg, err);
+    if (!err.empty() || cancelSweep.cancelled() || finished.edges.size() != uncancelled.edges.size()
+        || finished.curvedEdges.size() != uncancelled.curvedEdges.size())
+      throw std::runtime_error("Failed to resume cancelled sweep");
+
+    // five sites with four Delaunay triangles close four arcs, the
+    // last at y = -1.7396; removing an arc keeps the surviving edge
+    std::vector<Polygon> fivePoints(5);
+    fivePoints[0].addPoint(vec2(-0.423456, -0.3234526));
+    fivePoints[1].addPoint(vec2(-0.0234, 0.834562));
+    fivePoints[2].addPoint(vec2(0.5635, -0.343262));
+    fivePoints[3].addPoint(vec2(-0.2335, 0.6262));
+    fivePoints[4].addPoint(vec2(0.245215, 0.15835325));
+    SweepState fiveSweep(createDataQueue(fivePoints));
+    auto fiveRslt = fiveSweep.advance(-2.0, msg, err);
+    if (!err.empty() || fiveSweep.eventCount() != 9 || fiveRslt.edges.size() != 8)
+      throw std::runtime_error("Failed voronoi of five points with " + std::to_string(fiveSweep.eventCount())
+                               + " events and " + std::to_string(fiveRslt.edges.size()) + " edges");
+
+    auto c1 = newCloseEvent(0.6, NULL_NODE, 0, vec2(0.0, 0.0));
+    auto c2 = newCloseEvent(0.3999, NULL_NODE, 0, vec2(0.0, 0.0));
     std::vector<CloseEvent> cQueue = {c1, c2};
-    auto c3 = newCloseEvent(0.5999, nullptr, vec2(0.0, 0.0));
+    auto c3 = newCloseEvent(0.5999, NULL_NODE, 0, vec2(0.0, 0.0));
 
     cQueue.push_back(c3);
     std::sort(cQueue.begin(), cQueue.end(), close_event_less_than());
@@ -96,6 +393,51 @@ int main(int /* argc */, char** /* argv */)
       printCloseEvent(elem);
     }
 
+    NodeArena arena;
+    auto n1 = arena.create(ArcType_e::ARC_PARA, 0);
+    auto n2 = arena.create(ArcType_e::ARC_PARA, 0);
+    auto n3 = arena.create(ArcType_e::ARC_PARA, 0);
+    auto pending = [&arena](decimal_t y, node_t n) {
+      return newCloseEvent(y, n, arena[n].generation, vec2(0.0, 0.0));
+    };
+    // cancelling an arc drops all of its pending events in both
+    // modes, so both leave the same live events
+    auto live = [&arena](CloseEventQueue& rQueue) {
+      std::vector<std::pair<node_t, decimal_t>> rslt;
+      while (!rQueue.empty())
+      {
+        auto e = rQueue.pop();
+        if (!CloseEventQueue::isStale(e, arena)) rslt.push_back({e.arcNode, e.yval});
+      }
+      return rslt;
+    };
+    auto cancelled = [&](CancelMode_e mode) {
+      CloseEventQueue queue(mode);
+      queue.push(pending(0.2, n1));
+      queue.push(pending(0.7, n2));
+      queue.push(pending(0.5, n3));
+      queue.push(pending(-0.1, n2));
+      queue.cancel(n3, arena);
+      queue.cancel(n2, arena);
+      queue.push(pending(0.4, n2));
+      return queue;
+    };
+    auto heap = cancelled(CancelMode_e::EAGER);
+    if (heap.size() != 2)
+      throw std::runtime_error("Failed close queue erase");
+    auto eagerLive = live(heap);
+    auto lazyHeap = cancelled(CancelMode_e::LAZY);
+    auto lazyLive = live(lazyHeap);
+    if (eagerLive != lazyLive || eagerLive.size() != 2 || eagerLive[0].first != n2 || eagerLive[0].second != 0.4
+        || eagerLive[1].first != n1)
+      throw std::runtime_error("Failed close event cancel modes");
+
+    // released nodes are reused and their pending events go stale
+    arena.release(n3);
+    auto n4 = arena.create(ArcType_e::ARC_V, 0);
+    if (n4 != n3 || arena.size() != 3 || !CloseEventQueue::isStale(newCloseEvent(0.1, n3, 0, vec2(0.0, 0.0)), arena))
+      throw std::runtime_error("Failed node arena reuse");
+
     std::cout << "All unit tests passed\n";
   }
   catch(const std::exception& e)
@@ -1,8 +1,12 @@
 #include "types.hh"
 
+#include <algorithm>
 #include <memory>
 #include <cmath>
 
+namespace GVD_SCALAR_NS
+{
+
 Event makeSegment(vec2 p1, vec2 p2, uint32_t label, bool forceOrder)
 {
   if (forceOrder)
@@ -15,83 +19,82 @@ Event makeSegment(vec2 p1, vec2 p2, uint32_t label, bool forceOrder)
 Node::Node(ArcType_e _aType, uint32_t label)
   : aType(_aType),
   side(Side_e::UNDEFINED),
-  id(g_nodeId++),
-  pLeft(nullptr),
-  pRight(nullptr),
-  pParent(nullptr),
+  left(NULL_NODE),
+  right(NULL_NODE),
+  parent(NULL_NODE),
+  prev(NULL_NODE),
+  next(NULL_NODE),
   edgeStart(vec2(0.0,0.0)),
   point(vec2(0.0,0.0)),
   a(vec2(0.0,0.0)),
   b(vec2(0.0,0.0)),
   overridden(false),
   label(label),
-  visited(false)
+  site(0),
+  bisector(std::numeric_limits<uint32_t>::max()),
+  generation(0),
+  height(1),
+  arcs(1)
 {}
 
-//------------------------------------------------------------
-// prevEdge
-// Returns the previous in-order edge arcNode. Find the first
-// ancestor to the left.
-//------------------------------------------------------------
-std::shared_ptr<Node> Node::prevEdge()
+NodeArena::NodeArena()
+  : m_blocks(), m_count(0), m_free()
+{}
+
+NodeArena::NodeArena(NodeArena const& other)
+  : m_blocks(), m_count(0), m_free()
 {
-  auto node = pParent;
-  auto childId = id; // ID must be unique
-  while (node && node->pLeft && node->pLeft->id == childId)
-  {
-    childId = node->id;
-    node = node->pParent;
-  }
-  return node;
+  *this = other;
 }
 
-std::shared_ptr<Node> Node::nextEdge()
+NodeArena& NodeArena::operator=(NodeArena const& other)
 {
-  auto node = pParent;
-  auto childId = id; // ID must be unique
-  while (node && node->pRight && node->pRight->id == childId)
-  {
-    childId = node->id;
-    node = node->pParent;
-  }
-  return node;
+  if (this == &other) return *this;
+  // only the used blocks are copied
+  auto usedBlocks = (other.m_count + BLOCK_MASK) >> BLOCK_BITS;
+  while (m_blocks.size() < usedBlocks)
+    m_blocks.emplace_back(new Node[BLOCK_SIZE]);
+  for (size_t i = 0; i < usedBlocks; ++i)
+    std::copy(other.m_blocks[i].get(), other.m_blocks[i].get() + BLOCK_SIZE, m_blocks[i].get());
+  m_count = other.m_count;
+  m_free = other.m_free;
+  return *this;
 }
 
-std::shared_ptr<Node> Node::prevArc()
+node_t NodeArena::create(ArcType_e aType, uint32_t label)
 {
-  std::shared_ptr<Node> node = nullptr;
-  if (aType == ArcType_e::ARC_V || aType == ArcType_e::ARC_PARA)
+  node_t n;
+  if (!m_free.empty())
   {
-    node = prevEdge();
-    if (!node) return nullptr;
-    node = node->pLeft;
+    n = m_free.back();
+    m_free.pop_back();
   }
   else
-    node = pLeft;
-
-  while (node && node->aType == ArcType_e::EDGE)
   {
-    node = node->pRight;
+    if ((m_count >> BLOCK_BITS) == m_blocks.size())
+      m_blocks.emplace_back(new Node[BLOCK_SIZE]);
+    n = m_count++;
   }
-  return node;
+
+  auto& node = (*this)[n];
+  // the generation survives reuse so old close events stay stale
+  auto generation = node.generation;
+  node = Node(aType, label);
+  node.generation = generation;
+  return n;
 }
 
-std::shared_ptr<Node> Node::nextArc()
+void NodeArena::release(node_t n)
 {
-  std::shared_ptr<Node> node = nullptr;
-  if (aType == ArcType_e::ARC_V || aType == ArcType_e::ARC_PARA)
-  {
-    node = nextEdge();
-    if (!node) return nullptr;
-    node = node->pRight;
-  }
-  else
-    node = pRight;
+  ++(*this)[n].generation;
+  m_free.push_back(n);
+}
 
-  while (node && node->aType == ArcType_e::EDGE)
-  {
-    node = node->pLeft;
-  }
-  return node;
+void NodeArena::reset()
+{
+  // nodes are trivially destructible, the blocks are kept for reuse
+  m_count = 0;
+  m_free.clear();
 }
 
+} // namespace GVD_SCALAR_NS
@@ -1,20 +1,37 @@
 #ifndef TYPES_HH
 #define TYPES_HH
 
+#include "scalar.hh"
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <initializer_list>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <new>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
-static uint32_t g_id = 0;
-static uint32_t g_labelCount = 0;
+namespace GVD_SCALAR_NS
+{
 
-/////////////////////////////////// Data Structures /////////////////////////////////////
+// one counter for the engine so site ids are unique across files,
+// atomic so datasets can be loaded on several threads. Only new
+// sites take an id, the sweep reuses theirs.
+inline std::atomic<uint32_t> g_id(0);
+// polygon labels, atomic so polygons can be created on any thread
+inline std::atomic<uint32_t> g_labelCount(0);
+
+// first of count consecutive polygon labels
+inline uint32_t reserveLabels(uint32_t count)
+{
+  return g_labelCount.fetch_add(count);
+}
 
-typedef long double decimal_t;
-// for better precision perhaps try
-// typedef _Float128 decimal_t;
+/////////////////////////////////// Data Structures /////////////////////////////////////
 
 struct vec2
 {
@@ -32,6 +49,76 @@ struct vec4
   decimal_t w;
 };
 
+//------------------------------------------------------------
+// FixedVec
+// Vector with inline storage for at most N elements, used for
+// the small candidate lists of the intersection kernel so the
+// sweep does not touch the heap. Elements are constructed on
+// push_back, pushing past N throws.
+//------------------------------------------------------------
+template <typename T, size_t N>
+class FixedVec
+{
+public:
+  FixedVec() : m_size(0) {}
+
+  FixedVec(std::initializer_list<T> items) : m_size(0)
+  {
+    for (auto&& i : items) push_back(i);
+  }
+
+  FixedVec(FixedVec const& other) : m_size(0)
+  {
+    for (auto&& i : other) push_back(i);
+  }
+
+  FixedVec& operator=(FixedVec const& other)
+  {
+    if (this == &other) return *this;
+    clear();
+    for (auto&& i : other) push_back(i);
+    return *this;
+  }
+
+  ~FixedVec() { clear(); }
+
+  void push_back(T const& item)
+  {
+    if (m_size == N) throw std::runtime_error("FixedVec capacity exceeded");
+    new (data() + m_size) T(item);
+    ++m_size;
+  }
+
+  void clear()
+  {
+    for (size_t i = 0; i < m_size; ++i) data()[i].~T();
+    m_size = 0;
+  }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  T& operator[](size_t i) { return data()[i]; }
+  T const& operator[](size_t i) const { return data()[i]; }
+  T& front() { return data()[0]; }
+  T const& front() const { return data()[0]; }
+  T& back() { return data()[m_size - 1]; }
+  T const& back() const { return data()[m_size - 1]; }
+
+  T* begin() { return data(); }
+  T* end() { return data() + m_size; }
+  T const* begin() const { return data(); }
+  T const* end() const { return data() + m_size; }
+
+private:
+  T* data() { return reinterpret_cast<T*>(m_storage); }
+  T const* data() const { return reinterpret_cast<T const*>(m_storage); }
+
+  alignas(T) unsigned char m_storage[N * sizeof(T)];
+  size_t m_size;
+};
+
 enum class EventType_e
 {
   SEG = 1,
@@ -54,12 +141,32 @@ enum class Side_e
   UNDEFINED = 3
 };
 
-static uint32_t g_nodeId = 0;
+//------------------------------------------------------------
+// SegmentV
+// Directrix independent constants of the V of a segment site.
+// The arms bisect the segment and the directrix so only the
+// apex moves with the directrix. Filled by math::createSegmentV.
+//------------------------------------------------------------
+struct SegmentV
+{
+  SegmentV() : dx(0.0), dy(0.0), cross(0.0), arms{{vec2(0.0, 0.0), vec2(0.0, 0.0)}} {}
+
+  decimal_t dx; // upper minus lower endpoint
+  decimal_t dy;
+  decimal_t cross; // upper.x * lower.y - upper.y * lower.x
+  std::array<vec2, 2> arms; // left and right arm unit vectors
+};
+
+// 32-bit handle of a Node in a NodeArena
+typedef uint32_t node_t;
+static const node_t NULL_NODE = std::numeric_limits<node_t>::max();
+
 //------------------------------------------------------------
 // EdgeNode
 // left and right are the left and right children nodes.
-// left is always an ArcNode. Right may be an ArcNode or
-// EdgeNode.
+// Either may be an ArcNode or EdgeNode. The beachline is
+// kept height balanced so edges are rotated freely, an edge
+// is defined by its in-order neighbor arcs, not its children.
 //------------------------------------------------------------
 //------------------------------------------------------------
 // ArcNode - active node segment in the beachline
@@ -67,34 +174,106 @@ static uint32_t g_nodeId = 0;
 class Node
 {
 public:
+  Node() : Node(ArcType_e::UNDEFINED, 0) {}
   Node(ArcType_e _aType, uint32_t label);
 
-  std::shared_ptr<Node> prevEdge();
-  std::shared_ptr<Node> nextEdge();
-
-  std::shared_ptr<Node> prevArc();
-  std::shared_ptr<Node> nextArc();
-
   ArcType_e aType; // otherwise an edge - also set when Edge finalized
   Side_e side; // which side of the edge
-  uint32_t id;
-  std::shared_ptr<Node> pLeft; // Shared pointer is only a problem if we are point to self
-  std::shared_ptr<Node> pRight;
-  std::shared_ptr<Node> pParent; // TODO make this a weak_ptr to avoid circular ownership
+  node_t left;
+  node_t right;
+  node_t parent;
+  // in-order neighbors, arcs link to their bounding edges and
+  // edges to their bounding arcs
+  node_t prev;
+  node_t next;
   vec2 edgeStart;
   vec2 point;
   vec2 a;
   vec2 b;
+  SegmentV v; // ARC_V only
   bool overridden;
   uint32_t label;
-  bool visited;
+  uint32_t site; // id of the site event, arcs only
+  uint32_t bisector; // BisectorCache slot of the bounding arcs, edges only
+  uint32_t generation; // bumped to lazily cancel pending close events
+  uint32_t height; // subtree height, arcs are 1
+  uint32_t arcs; // arcs in the subtree, arcs are 1
   private:
 };
 
+//------------------------------------------------------------
+// NodeArena
+// Per-run pool of beachline nodes. Nodes link to each other
+// with 32-bit handles so traversals do no refcounting and the
+// tree has no ownership cycles. Storage is split in fixed size
+// blocks so a Node reference stays valid while nodes are
+// created. Released nodes are reused, their generation keeps
+// counting so close events pointing at them become stale.
+// Nodes are threaded in-order so neighbor lookups are O(1).
+// reset() drops every node in O(1) and keeps the blocks.
+//------------------------------------------------------------
+class NodeArena
+{
+public:
+  NodeArena();
+  NodeArena(NodeArena const& other);
+  NodeArena& operator=(NodeArena const& other);
+
+  node_t create(ArcType_e aType, uint32_t label);
+  void release(node_t n);
+  void reset();
+
+  Node& operator[](node_t n) { return m_blocks[n >> BLOCK_BITS][n & BLOCK_MASK]; }
+  Node const& operator[](node_t n) const { return m_blocks[n >> BLOCK_BITS][n & BLOCK_MASK]; }
+
+  // in-order neighbors of an arc
+  node_t prevEdge(node_t n) const { return (*this)[n].prev; }
+  node_t nextEdge(node_t n) const { return (*this)[n].next; }
+
+  // bounding arcs of an edge or neighbor arcs of an arc
+  node_t prevArc(node_t n) const
+  {
+    auto const& node = (*this)[n];
+    if (node.aType == ArcType_e::EDGE || node.prev == NULL_NODE) return node.prev;
+    return (*this)[node.prev].prev;
+  }
+
+  node_t nextArc(node_t n) const
+  {
+    auto const& node = (*this)[n];
+    if (node.aType == ArcType_e::EDGE || node.next == NULL_NODE) return node.next;
+    return (*this)[node.next].next;
+  }
+
+  // thread a and b as in-order neighbors
+  void link(node_t a, node_t b)
+  {
+    if (a != NULL_NODE) (*this)[a].next = b;
+    if (b != NULL_NODE) (*this)[b].prev = a;
+  }
+
+  size_t size() const { return m_count - m_free.size(); }
+  // slots handed out, what a copy of the arena stores
+  size_t slots() const { return m_count; }
+
+private:
+  static const uint32_t BLOCK_BITS = 10;
+  static const uint32_t BLOCK_SIZE = 1 << BLOCK_BITS;
+  static const uint32_t BLOCK_MASK = BLOCK_SIZE - 1;
+
+  std::vector<std::unique_ptr<Node[]>> m_blocks;
+  uint32_t m_count; // slots handed out, including released ones
+  std::vector<node_t> m_free;
+};
+
 struct Event
 {
   Event(EventType_e _type, uint32_t l, vec2 _p = vec2(0.0,0.0), vec2 _a = vec2(0.0,0.0), vec2 _b = vec2(0.0,0.0))
-  : type(_type), id(g_id++), label(l), point(_p), a(_a), b(_b) {}
+  : Event(g_id++, _type, l, _p, _a, _b) {}
+  // the event of an existing site
+  Event(uint32_t _id, EventType_e _type, uint32_t l, vec2 _p = vec2(0.0,0.0), vec2 _a = vec2(0.0,0.0),
+        vec2 _b = vec2(0.0,0.0))
+  : type(_type), id(_id), label(l), point(_p), a(_a), b(_b) {}
 
   EventType_e type;
   uint32_t id;
@@ -107,11 +286,12 @@ struct Event
 struct CloseEvent
 {
   // close event items
-  CloseEvent() : point(0.0, 0.0), arcNode(nullptr), yval(0.0) {};
+  CloseEvent() : point(0.0, 0.0), arcNode(NULL_NODE), yval(0.0), generation(0) {};
   vec2 point;
   // bool live;
-  std::shared_ptr<Node> arcNode;
+  node_t arcNode; // handle into the sweep's NodeArena
   decimal_t yval;
+  uint32_t generation; // arcNode generation the event was created against
 };
 
 struct close_event_less_than
@@ -142,44 +322,20 @@ inline void printEvent(Event const& e)
 struct EventPacket
 {
   Event site;
-  std::vector<Event> children; //[0] - left/single child [1] - right
+  FixedVec<Event, 2> children; //[0] - left/single child [1] - right
 };
 
-inline CloseEvent newCloseEvent(decimal_t y, std::shared_ptr<Node> const& arcNode, vec2 point)
+inline CloseEvent newCloseEvent(decimal_t y, node_t arcNode, uint32_t generation, vec2 point)
 {
   CloseEvent r;
   r.point = point;
   r.arcNode = arcNode;
   // arcNode->live = true;
   r.yval = y;
+  r.generation = generation;
   return r;
 }
 
-inline void sortedInsert(CloseEvent const& e, std::vector<CloseEvent>& rQueue)
-{
-  if (e.arcNode->id == 644 || e.arcNode->id == 114)
-  {
-    std::cout << "testing\n";
-  }
-  // PERFORMANCE - see if we can speed this up
-  rQueue.push_back(e);
-  std::sort(rQueue.begin(), rQueue.end(), close_event_less_than());
-}
-
-// TODO performance
-inline void removeCloseEventFromQueue(uint32_t id, std::vector<CloseEvent>& q)
-{
-  if (id == 644 || id == 114)
-  {
-    std::cout << "testing\n";
-  }
-  auto itr = std::find_if(q.begin(), q.end(), [&id](CloseEvent const& e){
-    return e.arcNode && e.arcNode->id == id;
-  });
-  if (itr != q.end())
-    q.erase(itr);
-}
-
 inline void printCloseEvent(CloseEvent const& e)
 {
   std::cout << "Close Event: point(" << e.point.x << ","
@@ -191,14 +347,15 @@ Event makeSegment(vec2 p1, vec2 p2, uint32_t label, bool forceOrder);
 class Polygon
 {
 public:
-  Polygon() : orderedPointSites(), label(g_labelCount++) {}
+  Polygon() : Polygon(reserveLabels(1)) {}
+  explicit Polygon(uint32_t _label) : orderedPointSites(), label(_label) {}
 
   void addPoint(vec2 const& loc)
   {
     orderedPointSites.push_back(Event(EventType_e::POINT, label, loc));
   }
 
-  std::vector<Event> getSegments()
+  std::vector<Event> getSegments() const
   {
     if (orderedPointSites.size() < 2) return {};
     if (orderedPointSites.size() == 2)
@@ -207,6 +364,7 @@ public:
     };
 
     std::vector<Event> rslt;
+    rslt.reserve(orderedPointSites.size());
     auto p1 = orderedPointSites[0].point;
     for (size_t i = 1; i < orderedPointSites.size(); ++i)
     {
@@ -221,11 +379,13 @@ public:
     return rslt;
   }
 
-  uint32_t getLabel() { return label; }
+  uint32_t getLabel() const { return label; }
 
   std::vector<Event> orderedPointSites;
 private:
   uint32_t label;
 };
 
+} // namespace GVD_SCALAR_NS
+
 #endif
@@ -1,8 +1,13 @@
 #include "utils.hh"
+#include "parallel.hh"
 
 #include <algorithm>
 #include <iostream>
-#include <map>
+#include <limits>
+#include <unordered_map>
+
+namespace GVD_SCALAR_NS
+{
 
 namespace
 {
@@ -20,82 +25,159 @@ namespace
     }
   }
 
-  Polygon getPolyByLabel(uint32_t label, std::vector<Polygon> const& polygons)
+  //------------------------------------------------------------
+  // sortPointSites
+  // Point sites of all polygons in event_less_than order. The
+  // sites are radix sorted as (y, x) keys rounded to double. Sites
+  // whose y rounds to the same double may still differ in y, so
+  // every run sharing the y key is sorted again exactly, then the
+  // sites are copied once in sorted order.
+  //------------------------------------------------------------
+  std::vector<Event> sortPointSites(std::vector<Polygon> const& polygons)
   {
-    auto f = std::find_if(polygons.begin(), polygons.end(), [label](Polygon poly){
-      if (label == poly.getLabel())
-        return true;
-      return false;
+    std::vector<Event const*> sites;
+    for (auto&& p : polygons)
+    {
+      for (auto&& s : p.orderedPointSites) sites.push_back(&s);
+    }
+
+    std::cout << "sorting points size:" << sites.size() << std::endl;
+    std::vector<SortKey> keys(sites.size());
+    parallelFor(sites.size(), [&](size_t i) {
+      auto const& p = sites[i]->point;
+      keys[i] = {orderedBits(static_cast<double>(p.y)), orderedBits(static_cast<double>(p.x)), static_cast<uint32_t>(i)};
     });
-    if (f != polygons.end())
-      return (*f);
+    radixSort(keys);
 
-    throw std::runtime_error("failed to locate polygon with label:" + std::to_string(label));
-    return Polygon();
+    auto exactLess = [&sites](SortKey const& lhs, SortKey const& rhs) {
+      return math::event_less_than()(*sites[lhs.index], *sites[rhs.index]);
+    };
+    for (size_t i = 0; i < keys.size();)
+    {
+      auto j = i + 1;
+      while (j < keys.size() && keys[j].hi == keys[i].hi) ++j;
+      if (j - i > 1) std::stable_sort(keys.begin() + i, keys.begin() + j, exactLess);
+      i = j;
+    }
+
+    std::vector<Event> rslt;
+    rslt.reserve(keys.size());
+    for (auto&& k : keys) rslt.push_back(*sites[k.index]);
+    std::cout << "sorted points\n";
+    return rslt;
   }
-}
 
-std::vector<Event> createDataQueue(std::vector<Polygon> const& polygons)
-{
-  std::vector<Event> rslt;
-  std::vector<Event> points;
-  for (auto&& p : polygons)
+  //------------------------------------------------------------
+  // PolygonSegments
+  // Segments of a polygon indexed by their upper endpoint. Equal
+  // endpoints are chained in segment order so a lookup returns
+  // the segments in the order getSegments() made them.
+  //------------------------------------------------------------
+  struct vec2_hash
   {
-    // auto toAdd = p.getPointSites();
-    // points.insert(points.end(), toAdd.begin(), toAdd.end());
-    for (auto s : p.orderedPointSites)
+    size_t operator()(vec2 const& v) const
     {
-      points.push_back(s);
+      auto h = std::hash<double>()(static_cast<double>(v.x));
+      return h ^ (std::hash<double>()(static_cast<double>(v.y)) + 0x9e3779b9 + (h << 6) + (h >> 2));
     }
-  }
+  };
 
-  std::cout << "sorting points size:" << points.size() << std::endl;
-  std::sort(points.begin(), points.end(), math::event_less_than());
-  std::cout << "sorted points\n";
-  // sanitize across sites
-  sanitizePointSiteData(points);
+  struct vec2_equal
+  {
+    bool operator()(vec2 const& a, vec2 const& b) const { return a.x == b.x && a.y == b.y; }
+  };
 
-  std::map<uint32_t, std::vector<Event>> generatedSegs;
-  for(auto&& sortedP : points)
+  class PolygonSegments
   {
-    std::vector<Event> ss;
-    if (generatedSegs.find(sortedP.label) != generatedSegs.end())
+  public:
+    explicit PolygonSegments(Polygon const& poly)
+      : m_segments(poly.getSegments()), m_next(m_segments.size(), NONE), m_starts()
     {
-      ss = generatedSegs.at(sortedP.label);
+      m_starts.reserve(m_segments.size());
+      for (uint32_t i = 0; i < m_segments.size(); ++i)
+      {
+        auto found = m_starts.find(m_segments[i].a);
+        if (found == m_starts.end())
+        {
+          m_starts.emplace(m_segments[i].a, std::make_pair(i, i));
+          continue;
+        }
+        m_next[found->second.second] = i;
+        found->second.second = i;
+      }
     }
-    else
+
+    // segments whose upper endpoint is v
+    FixedVec<Event const*, 3> startingAt(vec2 const& v) const
     {
-      auto poly = getPolyByLabel(sortedP.label, polygons);
-      ss = poly.getSegments();
-      generatedSegs.emplace(sortedP.label, ss);
+      FixedVec<Event const*, 3> rslt;
+      auto found = m_starts.find(v);
+      if (found == m_starts.end()) return rslt;
+      // only the first two are used, see createDataQueue
+      for (auto i = found->second.first; i != NONE && rslt.size() < rslt.capacity(); i = m_next[i])
+        rslt.push_back(&m_segments[i]);
+      return rslt;
     }
 
-    std::vector<Event> connectedSegs;
-    std::copy_if(ss.begin(), ss.end(), std::back_inserter(connectedSegs),
-    [v = sortedP.point](Event const& s){return math::equiv2(s.a, v);});
+  private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    std::vector<Event> m_segments;
+    std::vector<uint32_t> m_next; // next segment with the same upper endpoint
+    std::unordered_map<vec2, std::pair<uint32_t, uint32_t>, vec2_hash, vec2_equal> m_starts; // first, last
+  };
+}
+
+std::vector<Event> createDataQueue(std::vector<Polygon> const& polygons)
+{
+  auto points = sortPointSites(polygons);
+  // sanitize across sites
+  sanitizePointSiteData(points);
 
+  // polygons by label, each with its segments indexed by upper endpoint
+  std::vector<PolygonSegments> segments;
+  segments.reserve(polygons.size());
+  std::unordered_map<uint32_t, size_t> labelIndex;
+  labelIndex.reserve(polygons.size());
+  for (auto&& p : polygons)
+  {
+    if (labelIndex.emplace(p.getLabel(), segments.size()).second)
+      segments.emplace_back(p);
+  }
+
+  std::vector<Event> rslt;
+  rslt.reserve(points.size() * 2);
+  for(auto&& sortedP : points)
+  {
+    auto found = labelIndex.find(sortedP.label);
+    if (found == labelIndex.end())
+      throw std::runtime_error("failed to locate polygon with label:" + std::to_string(sortedP.label));
+
+    auto connectedSegs = segments[found->second].startingAt(sortedP.point);
     if (!connectedSegs.empty())
     {
       if (connectedSegs.size() == 2)
       {
         // add the segments if order of left to right
-        if (math::isRightOfLine(connectedSegs[0].a, connectedSegs[0].b, connectedSegs[1].b))
+        if (math::isRightOfLine(connectedSegs[0]->a, connectedSegs[0]->b, connectedSegs[1]->b))
         {
-          rslt.push_back(connectedSegs[0]);
-          rslt.push_back(connectedSegs[1]);
+          rslt.push_back(*connectedSegs[0]);
+          rslt.push_back(*connectedSegs[1]);
         }
         else
         {
-          rslt.push_back(connectedSegs[1]);
-          rslt.push_back(connectedSegs[0]);
+          rslt.push_back(*connectedSegs[1]);
+          rslt.push_back(*connectedSegs[0]);
         }
       }
       else
       {
-        rslt.push_back(connectedSegs[0]);
+        rslt.push_back(*connectedSegs[0]);
       }
     }
-    rslt.push_back(sortedP);
+    rslt.push_back(std::move(sortedP));
   }
   return rslt;
 }
+
+} // namespace GVD_SCALAR_NS
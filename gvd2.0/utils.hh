@@ -6,6 +6,11 @@
 #include "types.hh"
 #include "math.hh"
 
+namespace GVD_SCALAR_NS
+{
+
 std::vector<Event> createDataQueue(std::vector<Polygon> const& polygons);
 
+} // namespace GVD_SCALAR_NS
+
 #endif